@@ -0,0 +1,70 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ *  Example:      CoarseFine
+ *  Description:  Read one potentiometer as two selectors at once, a coarse
+ *                4 position mode and a fine 32 position value, using a
+ *                single analog reading for both.
+ */
+
+#include <AnalogSelector.h>
+
+const int Pin = A0;
+
+AnalogSelectorFilter coarse(0, 1023, 4, 0.2);
+AnalogSelectorFilter fine(0, 1023, 32, 0.2);
+
+AnalogSelectorFilter* filters[] = { &coarse, &fine };
+const int NumFilters = sizeof(filters) / sizeof(filters[0]);
+
+AnalogSelectorFanout knob(Pin, filters, NumFilters);
+
+unsigned int previous[NumFilters];
+
+
+void setup() {
+	Serial.begin(115200);
+	while (!Serial);
+
+	knob.begin();
+	delay(500);
+}
+
+void loop() {
+	unsigned int current[NumFilters];
+	knob.getPositions(current);
+
+	if (current[0] != previous[0] || current[1] != previous[1]) {
+		Serial.print("Coarse: ");
+		Serial.print(current[0] + 1);
+		Serial.print(" / 4, Fine: ");
+		Serial.print(current[1] + 1);
+		Serial.print(" / 32");
+		Serial.println();
+
+		previous[0] = current[0];
+		previous[1] = current[1];
+	}
+}
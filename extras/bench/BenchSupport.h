@@ -0,0 +1,64 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <chrono>
+
+
+/**
+ * Minimal timing for the host benchmarks. Each run is repeated and the
+ * fastest is reported, as that's the one least disturbed by the rest of the
+ * system. Results are written to a volatile sink so the work can't be
+ * optimized away.
+ */
+static volatile unsigned int benchSink;
+
+template<typename Function>
+static double benchTime(Function run, size_t samples, int repeats = 5) {
+	double best = 0.0;
+
+	for (int r = 0; r < repeats; r++) {
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+
+		const double Time = std::chrono::duration<double, std::nano>(End - Start).count() / samples;
+		if (r == 0 || Time < best) best = Time;
+	}
+
+	return best;
+}
+
+static inline void benchReport(const char* name, double nsPerSample) {
+	printf("  %-40s %8.2f ns/sample\n", name, nsPerSample);
+}
+
+#endif
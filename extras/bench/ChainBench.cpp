@@ -0,0 +1,91 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Times each combination of stages in an AnalogSelectorChain, one sample at
+// a time and in blocks, against the same stages called by hand. The input
+// is a slow sweep with noise and occasional spikes, as from a noisy pot.
+
+#include "AnalogSelector.h"
+#include "BenchSupport.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+static const size_t Samples = 1 << 20;
+
+static std::vector<AnalogSelectorValue> input(Samples);
+static std::vector<unsigned int> output(Samples);
+
+template<typename Chain>
+static void runChain(const char* name) {
+	Chain chain(0, 1023, 12, 0.2f);
+	const double PerSample = benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += chain.process(input[i]);
+		benchSink = sum;
+	}, Samples);
+
+	Chain block(0, 1023, 12, 0.2f);
+	const double Block = benchTime([&]() {
+		block.process(input.data(), Samples, output.data());
+		benchSink = output[Samples / 2];
+	}, Samples);
+
+	printf("%s\n", name);
+	benchReport("per sample", PerSample);
+	benchReport("block", Block);
+}
+
+int main() {
+	srand(39);
+	for (size_t i = 0; i < Samples; i++) {
+		AnalogSelectorValue value = (AnalogSelectorValue) ((i >> 10) % 1024) + rand() % 9 - 4;
+		if (rand() % 64 == 0) value = rand() % 1024;  // spike
+		input[i] = value;
+	}
+
+	runChain< AnalogSelectorChain<AnalogSelectorFilter> >("filter");
+	runChain< AnalogSelectorChain<AnalogSelectorEma, AnalogSelectorFilter> >("ema -> filter");
+	runChain< AnalogSelectorChain<AnalogSelectorMedian<3>, AnalogSelectorFilter> >("median 3 -> filter");
+	runChain< AnalogSelectorChain<AnalogSelectorMedian<3>, AnalogSelectorEma, AnalogSelectorFilter> >("median 3 -> ema -> filter");
+	runChain< AnalogSelectorChain<AnalogSelectorMedian<5>, AnalogSelectorEma, AnalogSelectorFilter> >("median 5 -> ema -> filter");
+
+	// the glue the chain replaces, for comparison
+	AnalogSelectorMedian<3> median;
+	AnalogSelectorEma ema;
+	AnalogSelectorFilter filter(0, 1023, 12, 0.2f);
+	const double Manual = benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += filter.getPosition(ema.process(median.process(input[i])));
+		benchSink = sum;
+	}, Samples);
+
+	printf("median 3 -> ema -> filter, called by hand\n");
+	benchReport("per sample", Manual);
+
+	return 0;
+}
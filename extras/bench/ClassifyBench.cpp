@@ -0,0 +1,90 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Times the stateless classify() over tens of millions of samples: one
+// sample at a time, as one block, and split into blocks across threads with
+// OpenMP when it's enabled. The stateful filter is timed on the same input
+// for comparison.
+
+#include "AnalogSelector.h"
+#include "BenchSupport.h"
+
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static const size_t Samples = 50000000;
+
+int main() {
+	std::vector<int16_t> input(Samples);
+	std::vector<uint16_t> output(Samples);
+
+	// spread over the whole range, in no particular order
+	for (size_t i = 0; i < Samples; i++) input[i] = (int16_t) (((uint32_t) i * 2654435761U) >> 22);
+
+	AnalogSelectorFilter filter(0, 1023, 12, 0.2f);
+	filter.getPosition(0);  // calculate the layout
+
+	printf("%u samples\n", (unsigned int) Samples);
+
+	benchReport("getPosition(), stateful", benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += filter.getPosition(input[i]);
+		benchSink = sum;
+	}, Samples, 3));
+
+	benchReport("classify(), one sample at a time", benchTime([&]() {
+		for (size_t i = 0; i < Samples; i++) output[i] = (uint16_t) filter.classify(input[i]);
+		benchSink = output[Samples / 2];
+	}, Samples, 3));
+
+	benchReport("classify(), one block", benchTime([&]() {
+		filter.classify(input.data(), Samples, output.data());
+		benchSink = output[Samples / 2];
+	}, Samples, 3));
+
+#ifdef _OPENMP
+	const AnalogSelectorFilter& Layout = filter;
+	const long Blocks = 256;
+	const size_t BlockSize = (Samples + Blocks - 1) / Blocks;
+
+	char name[64];
+	snprintf(name, sizeof(name), "classify(), OpenMP blocks, threads: %d", omp_get_max_threads());
+	benchReport(name, benchTime([&]() {
+		#pragma omp parallel for
+		for (long b = 0; b < Blocks; b++) {
+			const size_t Start = b * BlockSize;
+			const size_t Count = (Start + BlockSize < Samples) ? BlockSize : Samples - Start;
+			Layout.classify(input.data() + Start, Count, output.data() + Start);
+		}
+		benchSink = output[Samples / 2];
+	}, Samples, 3));
+#endif
+
+	return 0;
+}
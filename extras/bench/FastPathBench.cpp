@@ -0,0 +1,78 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Measures what the inlined fast path of AnalogSelectorFilter::getPosition()
+// saves. Inputs that stay inside the current bounds are timed with the
+// check inlined and with the same call made out of line, and inputs that
+// cross an edge on every sample time the out-of-line slow path.
+
+#include "AnalogSelector.h"
+#include "BenchSupport.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+static const size_t Samples = 1 << 22;
+
+unsigned int getPositionOutOfLine(AnalogSelectorFilter& filter, AnalogSelectorValue pos);  // FastPathCall.cpp
+
+int main() {
+	std::vector<AnalogSelectorValue> steady(Samples);
+	std::vector<AnalogSelectorValue> crossing(Samples);
+
+	// noise around the center of position 2, and alternating between the
+	// centers of positions 1 and 3
+	srand(42);
+	for (size_t i = 0; i < Samples; i++) {
+		steady[i] = 512 + rand() % 17 - 8;
+		crossing[i] = (i & 1) ? 307 : 716;
+	}
+
+	AnalogSelectorFilter filter(0, 1023, 5, 0.2f);
+	filter.getPosition(512);
+
+	printf("in bounds\n");
+	benchReport("inline", benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += filter.getPosition(steady[i]);
+		benchSink = sum;
+	}, Samples));
+	benchReport("out of line", benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += getPositionOutOfLine(filter, steady[i]);
+		benchSink = sum;
+	}, Samples));
+
+	printf("crossing an edge on every sample\n");
+	benchReport("slow path", benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < Samples; i++) sum += filter.getPosition(crossing[i]);
+		benchSink = sum;
+	}, Samples));
+
+	return 0;
+}
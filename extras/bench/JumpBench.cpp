@@ -0,0 +1,79 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Compares the selection search before and after the closed form, with 128
+// positions. The 'walk' rows use the reference filter from the host tests,
+// which searches one position at a time from the current selection as the
+// library did before. Full-range jumps are the worst case for the walk, as
+// every sample steps through all of the positions.
+
+#include "AnalogSelector.h"
+#include "../test/ReferenceFilter.h"
+#include "BenchSupport.h"
+
+#include <stdlib.h>
+
+#include <vector>
+
+static const size_t Samples = 1 << 20;
+static const unsigned int Positions = 128;
+
+template<typename Filter>
+static double run(Filter& filter, const std::vector<AnalogSelectorValue>& input) {
+	return benchTime([&]() {
+		unsigned int sum = 0;
+		for (size_t i = 0; i < input.size(); i++) sum += filter.getPosition(input[i]);
+		benchSink = sum;
+	}, input.size());
+}
+
+static void compare(const char* name, AnalogSelectorValue rMin, AnalogSelectorValue rMax, const std::vector<AnalogSelectorValue>& input) {
+	AnalogSelectorFilter filter(rMin, rMax, Positions, 0.2f);
+	ReferenceFilter walk(rMin, rMax, Positions, 0.2f);
+
+	printf("%s\n", name);
+	benchReport("walk", run(walk, input));
+	benchReport("closed form", run(filter, input));
+}
+
+int main() {
+	std::vector<AnalogSelectorValue> input(Samples);
+
+	// end to end on every sample
+	for (size_t i = 0; i < Samples; i++) input[i] = (i & 1) ? 1023 : 0;
+	compare("full-range jumps, 0 - 1023", 0, 1023, input);
+
+	// random jumps, half of the range on average
+	srand(34);
+	for (size_t i = 0; i < Samples; i++) input[i] = rand() % 1024;
+	compare("random jumps, 0 - 1023", 0, 1023, input);
+
+	// a slow sweep with noise, where both stay in or next to the current position
+	for (size_t i = 0; i < Samples; i++) input[i] = (AnalogSelectorValue) ((i >> 10) % 1024) + rand() % 9 - 4;
+	compare("slow sweep, 0 - 1023", 0, 1023, input);
+
+	return 0;
+}
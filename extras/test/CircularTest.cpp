@@ -0,0 +1,153 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Verifies circular mode: sweeping around the range steps through the
+// positions one at a time in either direction, inputs outside the range
+// wrap, every input is inside the bound it selects, and the detent is
+// measured the short way around, including on the type's full range where
+// the circumference can't include the step back to the bottom.
+
+#include "AnalogSelector.h"
+#include "TestSupport.h"
+
+#include <random>
+
+static const int64_t ValueMin = (sizeof(AnalogSelectorValue) == 2) ? INT16_MIN : INT32_MIN;
+static const int64_t ValueMax = (sizeof(AnalogSelectorValue) == 2) ? INT16_MAX : INT32_MAX;
+
+static std::mt19937_64 rng(50);
+
+// Whether an input is inside the current bound, which may cross the top of
+// the range
+static bool inBound(const AnalogSelectorFilter& filter, int64_t pos) {
+	const int64_t Low = filter.getLowerEdge();
+	const int64_t High = filter.getUpperEdge();
+	return (Low <= High) ? (pos >= Low && pos <= High) : (pos >= Low || pos <= High);
+}
+
+// Sweeps three turns up and then three turns down, one step at a time.
+// A circular range needs at least two steps per position to fit them all,
+// and a single position holds the whole circle, so its edges meet.
+static void testSweeps(int64_t rMin, int64_t rMax) {
+	const int64_t Circumference = rMax - rMin + 1;
+
+	for (unsigned int n = 1; n <= 24 && 2 * (int64_t) n <= Circumference; n++) {
+		for (int d = 0; d <= 10; d += 2) {
+			AnalogSelectorFilter filter((AnalogSelectorValue) rMin, (AnalogSelectorValue) rMax, n, d / 10.0f);
+			filter.setCircular(true);
+			TEST_CHECK(filter.getCircumference() == (AnalogSelectorSpan) Circumference, "[%lld, %lld] circumference", (long long) rMin, (long long) rMax);
+
+			unsigned int previous = filter.getPosition((AnalogSelectorValue) (rMin + 1));
+			unsigned int steps = 0;
+
+			for (int64_t k = 1; k <= 3 * Circumference; k++) {
+				const int64_t Pos = rMin + ((1 + k) % Circumference);
+				const unsigned int Selection = filter.getPosition((AnalogSelectorValue) Pos);
+				if (Selection != previous) {
+					steps++;
+					TEST_CHECK(Selection == (previous + 1) % n, "[%lld, %lld] n %u dz %d up at %lld: %u -> %u",
+						(long long) rMin, (long long) rMax, n, d, (long long) Pos, previous, Selection);
+				}
+				TEST_CHECK(n == 1 || inBound(filter, Pos), "[%lld, %lld] n %u dz %d up at %lld outside bound",
+					(long long) rMin, (long long) rMax, n, d, (long long) Pos);
+				previous = Selection;
+			}
+			if (n > 1) {
+				TEST_CHECK(steps == 3 * n, "[%lld, %lld] n %u dz %d up %u steps", (long long) rMin, (long long) rMax, n, d, steps);
+			}
+
+			steps = 0;
+			for (int64_t k = 1; k <= 3 * Circumference; k++) {
+				const int64_t Pos = rMin + ((Circumference - (k % Circumference)) % Circumference);
+				const unsigned int Selection = filter.getPosition((AnalogSelectorValue) Pos);
+				if (Selection != previous) {
+					steps++;
+					TEST_CHECK(Selection == (previous + n - 1) % n, "[%lld, %lld] n %u dz %d down at %lld: %u -> %u",
+						(long long) rMin, (long long) rMax, n, d, (long long) Pos, previous, Selection);
+				}
+				TEST_CHECK(n == 1 || inBound(filter, Pos), "[%lld, %lld] n %u dz %d down at %lld outside bound",
+					(long long) rMin, (long long) rMax, n, d, (long long) Pos);
+				previous = Selection;
+			}
+			if (n > 1) {
+				TEST_CHECK(steps == 3 * n, "[%lld, %lld] n %u dz %d down %u steps", (long long) rMin, (long long) rMax, n, d, steps);
+			}
+
+			// inputs a turn above or below the range select the same position
+			for (int64_t pos = rMin; pos <= rMax; pos += 1 + Circumference / 64) {
+				const unsigned int Selection = filter.getPosition((AnalogSelectorValue) pos);
+				if (pos + Circumference <= ValueMax) {
+					TEST_CHECK(filter.getPosition((AnalogSelectorValue) (pos + Circumference)) == Selection, "wrap above at %lld", (long long) pos);
+				}
+				if (pos - Circumference >= ValueMin) {
+					TEST_CHECK(filter.getPosition((AnalogSelectorValue) (pos - Circumference)) == Selection, "wrap below at %lld", (long long) pos);
+				}
+			}
+		}
+	}
+}
+
+// On the type's full range, the detent is measured the short way around:
+// an offset is never more than half of the way around the circle
+static void testFullRangeDetent() {
+	const int64_t Half = (ValueMax - ValueMin) / 2 + 1;
+
+	for (unsigned int n = 1; n <= 40; n += 3) {
+		AnalogSelectorFilter filter((AnalogSelectorValue) ValueMin, (AnalogSelectorValue) ValueMax, n, 0.5f);
+		filter.setCircular(true);
+		TEST_CHECK(filter.getCircumference() == (AnalogSelectorSpan) -1, "full range circumference");
+
+		for (int i = 0; i < 20000; i++) {
+			const int64_t Pos = ValueMin + (int64_t) (rng() % (uint64_t) (ValueMax - ValueMin + 1));
+			filter.getPosition((AnalogSelectorValue) Pos);
+
+			const int64_t Probe = ValueMin + (int64_t) (rng() % (uint64_t) (ValueMax - ValueMin + 1));
+			const int64_t Offset = filter.getDetentOffset((AnalogSelectorValue) Probe);
+			TEST_CHECK(Offset >= -Half && Offset <= Half, "n %u at %lld offset %lld", n, (long long) Probe, (long long) Offset);
+		}
+
+		// either side of the top of the range is close to position 0's detent
+		filter.getPosition((AnalogSelectorValue) (ValueMin + (ValueMax - ValueMin) / (4 * n)));
+		TEST_CHECK(filter.getSelection() == 0, "n %u position 0", n);
+		const int64_t Above = filter.getDetentOffset((AnalogSelectorValue) ValueMin);
+		const int64_t Below = filter.getDetentOffset((AnalogSelectorValue) ValueMax);
+		TEST_CHECK(Below < 0 && Below >= Above - 2, "n %u across the top: %lld, %lld", n, (long long) Above, (long long) Below);
+		TEST_CHECK(filter.getDetentLevel((AnalogSelectorValue) ValueMax) + 1 >= filter.getDetentLevel((AnalogSelectorValue) ValueMin),
+			"n %u level across the top", n);
+	}
+}
+
+int main() {
+	testSweeps(0, 9);
+	testSweeps(0, 1023);
+	testSweeps(-50, 49);
+	testSweeps(100, 4195);
+	testSweeps(ValueMax - 999, ValueMax);
+	testSweeps(ValueMin, ValueMin + 999);
+	testFullRangeDetent();
+
+	return testReport("CircularTest");
+}
@@ -0,0 +1,91 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Verifies the closed-form selection in AnalogSelectorFilter against the
+// loop-based reference, for every input in several ranges, every position
+// count that fits, and a set of deadzone sizes. The inputs are approached
+// with sweeps from both ends, and by jumping to every input from every
+// position after reaching it from below and from above.
+
+#include "AnalogSelector.h"
+#include "ReferenceFilter.h"
+#include "TestSupport.h"
+
+static const float Deadzones[] = { 0.0f, 0.01f, 0.1f, 0.2f, 0.33f, 0.5f, 0.75f, 1.0f };
+
+static bool matches(const AnalogSelectorFilter& filter, const ReferenceFilter& reference, unsigned int selection) {
+	return selection == reference.getSelection()
+		&& filter.getLowerEdge() == reference.getLowerEdge()
+		&& filter.getUpperEdge() == reference.getUpperEdge();
+}
+
+static void testRange(int rMin, int rMax, unsigned int maxPositions) {
+	for (unsigned int n = 1; n <= maxPositions && n <= (unsigned int) (rMax - rMin); n++) {
+		for (float dz : Deadzones) {
+			AnalogSelectorFilter filter(rMin, rMax, n, dz);
+			ReferenceFilter reference(rMin, rMax, n, dz);
+
+			// sweeps through every input, past the ends of the range
+			for (int pos = rMin - 2; pos <= rMax + 2; pos++) {
+				const unsigned int Selection = filter.getPosition(pos);
+				reference.getPosition(pos);
+				TEST_CHECK(matches(filter, reference, Selection), "[%d, %d] n %u dz %.2f up to %d: %u, expected %u", rMin, rMax, n, dz, pos, Selection, reference.getSelection());
+			}
+			for (int pos = rMax + 2; pos >= rMin - 2; pos--) {
+				const unsigned int Selection = filter.getPosition(pos);
+				reference.getPosition(pos);
+				TEST_CHECK(matches(filter, reference, Selection), "[%d, %d] n %u dz %.2f down to %d: %u, expected %u", rMin, rMax, n, dz, pos, Selection, reference.getSelection());
+			}
+
+			// from every position, reached from either side, to every input
+			for (unsigned int from = 0; from < n; from++) {
+				for (int side = 0; side < 2; side++) {
+					const int Start = (int) ((side == 0) ? reference.calculateEdge(from, true) : reference.calculateEdge(from, false));
+
+					for (int pos = rMin - 1; pos <= rMax + 1; pos++) {
+						filter.getPosition((side == 0) ? rMin : rMax);
+						reference.getPosition((side == 0) ? rMin : rMax);
+						filter.getPosition(Start);
+						reference.getPosition(Start);
+
+						const unsigned int Selection = filter.getPosition(pos);
+						reference.getPosition(pos);
+						TEST_CHECK(matches(filter, reference, Selection), "[%d, %d] n %u dz %.2f from %u (side %d) to %d: %u, expected %u", rMin, rMax, n, dz, from, side, pos, Selection, reference.getSelection());
+					}
+				}
+			}
+		}
+	}
+}
+
+int main() {
+	testRange(0, 9, 9);
+	testRange(0, 1023, 24);
+	testRange(-37, 90, 40);
+	testRange(100, 4195, 12);
+
+	return testReport("ClosedFormTest");
+}
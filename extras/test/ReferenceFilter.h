@@ -0,0 +1,146 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef REFERENCE_FILTER_H
+#define REFERENCE_FILTER_H
+
+#include <stdint.h>
+
+
+/**
+ * @brief Loop-based reference model of AnalogSelectorFilter
+ * 
+ * This is the filter as it was before the selection was calculated in
+ * closed form. The widths are divided out once per configuration, and the
+ * selection walks one position at a time from the current one, checking the
+ * edges of each, until it finds the position that contains the input.
+ * 
+ * It includes the later layout fixes: the last position's upper edge is the
+ * top of the range, the deadzone range can't go negative with more positions
+ * than steps, the deadzone width can't round up past its maximum, and each
+ * position is at least one step wide. All
+ * of the math is 64-bit, so it can be compared against the library at any
+ * range its value type can hold.
+ */
+class ReferenceFilter {
+public:
+	ReferenceFilter(int64_t rMin, int64_t rMax, unsigned int numPos, float dz)
+		: currentSelection(0)
+	{
+		this->rangeMin = (rMin < rMax) ? rMin : rMax;
+		this->rangeMax = (rMin < rMax) ? rMax : rMin;
+		this->numPositions = (numPos != 0) ? numPos : 1;
+
+		     if (dz < 0.0) dz = 0.0;
+		else if (dz > 1.0) dz = 1.0;
+
+		const int64_t TotalRange = this->rangeMax - this->rangeMin;
+		const int64_t DeadzoneRange = (TotalRange > this->numPositions) ? TotalRange - this->numPositions : 0;
+		const int64_t NumDeadzones = this->numPositions - 1;
+		const int64_t MaxDeadzoneWidth = (NumDeadzones != 0) ? DeadzoneRange / NumDeadzones : 0;
+
+		const float DeadzoneWidth = (float) MaxDeadzoneWidth * dz;
+		this->deadzoneWidth = (DeadzoneWidth < (float) MaxDeadzoneWidth) ? (int64_t) DeadzoneWidth : MaxDeadzoneWidth;
+		this->selectorWidth = (TotalRange - this->deadzoneWidth * NumDeadzones) / this->numPositions;
+		if (this->selectorWidth == 0) this->selectorWidth = 1;
+
+		// the filter starts from its first argument, searching up from the bottom
+		calculateSelection(rMin, false);
+	}
+
+	unsigned int getPosition(int64_t pos) {
+		return calculateSelection(pos, true);
+	}
+
+	int64_t calculateEdge(unsigned int i, bool upper) const {
+		const int64_t TotalRange = this->rangeMax - this->rangeMin;
+		int64_t offset;
+
+		if (upper) {
+			if (i + 1 >= this->numPositions) offset = TotalRange;
+			else offset = (this->selectorWidth + this->deadzoneWidth) * (i + 1);
+		}
+		else {
+			offset = (this->selectorWidth * i) + (this->deadzoneWidth * ((i != 0) ? i - 1 : 0));
+		}
+
+		if (offset > TotalRange) offset = TotalRange;
+		return this->rangeMin + offset;
+	}
+
+	/// The center of a position, without its inner deadzones
+	int64_t calculateDetent(unsigned int i) const {
+		const int64_t Low  = calculateEdge(i, false) + ((i > 0) ? this->deadzoneWidth : 0);
+		const int64_t High = calculateEdge(i, true)  - ((i + 1 < this->numPositions) ? this->deadzoneWidth : 0);
+		return Low + (High - Low) / 2;
+	}
+
+	unsigned int getSelection() const { return this->currentSelection; }
+	unsigned int getNumPositions() const { return this->numPositions; }
+	int64_t getRangeMin() const { return this->rangeMin; }
+	int64_t getRangeMax() const { return this->rangeMax; }
+	int64_t getLowerEdge() const { return this->edgeLow; }
+	int64_t getUpperEdge() const { return this->edgeHigh; }
+
+private:
+	unsigned int calculateSelection(int64_t pos, bool relative) {
+		     if (pos < this->rangeMin) pos = this->rangeMin;
+		else if (pos > this->rangeMax) pos = this->rangeMax;
+
+		// walk up from the current selection (or the bottom) if above the
+		// upper edge, or down from it if below the lower edge
+		if (!relative || pos > this->edgeHigh) {
+			unsigned int i = relative ? this->currentSelection : 0;
+			while (i + 1 < this->numPositions && pos > calculateEdge(i, true)) i++;
+			setSelection(i);
+		}
+		else if (pos < this->edgeLow) {
+			unsigned int i = this->currentSelection;
+			while (i > 0 && pos < calculateEdge(i, false)) i--;
+			setSelection(i);
+		}
+
+		return this->currentSelection;
+	}
+
+	void setSelection(unsigned int i) {
+		this->currentSelection = i;
+		this->edgeLow = calculateEdge(i, false);
+		this->edgeHigh = calculateEdge(i, true);
+	}
+
+	int64_t rangeMin;
+	int64_t rangeMax;
+	unsigned int numPositions;
+	int64_t selectorWidth;
+	int64_t deadzoneWidth;
+
+	int64_t edgeLow;
+	unsigned int currentSelection;
+	int64_t edgeHigh;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Runs the noise reduction sleep sequence against a mock power controller,
+// with interrupts enabled and disabled by the caller and with other
+// interrupts waking the CPU before the conversion completes.
+
+#include "AnalogSelectorSleep.h"
+#include "TestSupport.h"
+
+
+/**
+ * Models the parts of the AVR that the sleep sequence touches. Entering
+ * sleep starts a conversion, and the CPU wakes either from the ADC interrupt
+ * when it completes or from one of a scripted number of other interrupts.
+ * Anything that would hang the real part, like sleeping with interrupts
+ * disabled or with nothing left to wake it, is recorded as an error.
+ */
+class MockPower {
+public:
+	/**
+	 * @param interrupts  The global interrupt state when the sequence starts
+	 * @param otherWakes  Number of other interrupts that wake the CPU first
+	 * @param finishAwake Whether the conversion completes while the CPU is
+	 *                    awake from the last of the other interrupts
+	*/
+	MockPower(bool interrupts, uint8_t otherWakes, bool finishAwake)
+		: interrupts(interrupts), adcInterrupt(false), sleepEnabled(false),
+		  otherWakes(otherWakes), finishAwake(finishAwake),
+		  state(Idle), sleeps(0), error(nullptr)
+	{}
+
+	uint8_t saveInterrupts() { return this->interrupts ? 0x80 : 0x00; }
+	void restoreInterrupts(uint8_t state) { this->interrupts = (state & 0x80) != 0; }
+	void enableInterrupts() { this->interrupts = true; }
+	void disableInterrupts() { this->interrupts = false; }
+
+	void beginSleep() {
+		this->adcInterrupt = true;
+		this->sleepEnabled = true;
+	}
+
+	void sleep() {
+		this->sleeps++;
+
+		if (!this->sleepEnabled) return fail("sleep is not enabled");
+		if (!this->interrupts)   return fail("slept with interrupts disabled");
+		if (!this->adcInterrupt) return fail("slept without the ADC interrupt");
+
+		if (this->state == Idle) this->state = Converting;  // entering sleep starts the conversion
+
+		if (this->otherWakes > 0) {
+			this->otherWakes--;
+			if (this->otherWakes == 0 && this->finishAwake) this->state = Complete;
+			return;
+		}
+
+		if (this->state == Converting) this->state = Complete;  // the ADC interrupt
+		else fail("slept with nothing left to wake the CPU");
+	}
+
+	bool converting() { return this->state == Converting; }
+
+	void endSleep() {
+		this->sleepEnabled = false;
+		this->adcInterrupt = false;
+	}
+
+	int result() {
+		if (this->state != Complete) fail("read the result before the conversion completed");
+		return 512;
+	}
+
+	bool interrupts;
+	bool adcInterrupt;
+	bool sleepEnabled;
+	uint8_t otherWakes;
+	bool finishAwake;
+	enum { Idle, Converting, Complete } state;
+	unsigned int sleeps;
+	const char* error;
+
+private:
+	void fail(const char* message) {
+		if (this->error == nullptr) this->error = message;
+	}
+};
+
+
+int main() {
+	for (int interrupts = 0; interrupts < 2; interrupts++) {
+		for (uint8_t wakes = 0; wakes <= 3; wakes++) {
+			for (int finishAwake = 0; finishAwake < 2; finishAwake++) {
+				if (wakes == 0 && finishAwake) continue;
+
+				MockPower power(interrupts != 0, wakes, finishAwake != 0);
+				const int Result = AnalogSelectorSleep<MockPower>::convert(power);
+
+				const unsigned int Sleeps = wakes + (finishAwake ? 0 : 1);
+				TEST_CHECK(power.error == nullptr, "interrupts %d, %u wakes, finish awake %d: %s", interrupts, wakes, finishAwake, power.error);
+				TEST_CHECK(Result == 512, "interrupts %d, %u wakes, finish awake %d: result %d", interrupts, wakes, finishAwake, Result);
+				TEST_CHECK(power.sleeps == Sleeps, "interrupts %d, %u wakes, finish awake %d: slept %u times, expected %u", interrupts, wakes, finishAwake, power.sleeps, Sleeps);
+				TEST_CHECK(power.interrupts == (interrupts != 0), "interrupts %d, %u wakes, finish awake %d: interrupt state not restored", interrupts, wakes, finishAwake);
+				TEST_CHECK(!power.sleepEnabled && !power.adcInterrupt, "interrupts %d, %u wakes, finish awake %d: sleep left enabled", interrupts, wakes, finishAwake);
+			}
+		}
+	}
+
+	return testReport("SleepTest");
+}
@@ -0,0 +1,57 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <stdio.h>
+
+
+/**
+ * Minimal checks for the host tests. Each test program counts its checks and
+ * failures, prints the first few failures with their location, and returns
+ * non-zero from main() if anything failed.
+ */
+static long testChecks = 0;
+static long testFailures = 0;
+
+#define TEST_CHECK(condition, ...) do {                          \
+		testChecks++;                                            \
+		if (!(condition)) {                                      \
+			if (testFailures++ < 10) {                           \
+				printf("%s:%d: failed: ", __FILE__, __LINE__);   \
+				printf(__VA_ARGS__);                             \
+				printf("\n");                                    \
+			}                                                    \
+		}                                                        \
+	} while (0)
+
+static inline int testReport(const char* name) {
+	printf("%s: %ld checks, %ld failures\n", name, testChecks, testFailures);
+	return (testFailures != 0) ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Verifies the filter at the limits of its value type, with the type's
+// full range and others near its ends, against the 64-bit reference. Built
+// with the default types, with ANALOG_SELECTOR_WIDE, and with 16-bit types
+// as on AVR, all under the undefined behavior sanitizer so that overflows
+// in the range math fail the test.
+
+#include "AnalogSelector.h"
+#include "ReferenceFilter.h"
+#include "TestSupport.h"
+
+#include <random>
+
+static const int64_t ValueMin = (sizeof(AnalogSelectorValue) == 2) ? INT16_MIN : INT32_MIN;
+static const int64_t ValueMax = (sizeof(AnalogSelectorValue) == 2) ? INT16_MAX : INT32_MAX;
+
+static std::mt19937_64 rng(47);
+
+static int64_t clampValue(int64_t value) {
+	return (value < ValueMin) ? ValueMin : ((value > ValueMax) ? ValueMax : value);
+}
+
+// A random input in [low, high]
+static int64_t randomIn(int64_t low, int64_t high) {
+	return low + (int64_t) (rng() % (uint64_t) (high - low + 1));
+}
+
+// Compares the filter to the reference for a stream of inputs that are
+// mostly close to the edges, where rounding and overflow show up
+static void testAgainstReference(int64_t rMin, int64_t rMax, unsigned int n, float dz, int samples) {
+	AnalogSelectorFilter filter((AnalogSelectorValue) rMin, (AnalogSelectorValue) rMax, n, dz);
+	ReferenceFilter reference(rMin, rMax, n, dz);
+
+	const int64_t Low = reference.getRangeMin();
+	const int64_t High = reference.getRangeMax();
+
+	for (int i = 0; i < samples; i++) {
+		int64_t pos;
+		switch (rng() % 4) {
+			case 0:  pos = randomIn(Low, High); break;
+			case 1:  pos = reference.calculateEdge(rng() % n, true)  + randomIn(-1, 1); break;
+			case 2:  pos = reference.calculateEdge(rng() % n, false) + randomIn(-1, 1); break;
+			default: pos = (rng() & 1) ? ValueMin : ValueMax; break;
+		}
+		pos = clampValue(pos);
+
+		const unsigned int Selection = filter.getPosition((AnalogSelectorValue) pos);
+		reference.getPosition(pos);
+
+		TEST_CHECK(Selection == reference.getSelection()
+			&& filter.getLowerEdge() == reference.getLowerEdge()
+			&& filter.getUpperEdge() == reference.getUpperEdge(),
+			"[%lld, %lld] n %u dz %.2f at %lld: %u [%lld, %lld], expected %u [%lld, %lld]",
+			(long long) rMin, (long long) rMax, n, dz, (long long) pos,
+			Selection, (long long) filter.getLowerEdge(), (long long) filter.getUpperEdge(),
+			reference.getSelection(), (long long) reference.getLowerEdge(), (long long) reference.getUpperEdge());
+
+		// the detent offset saturates to the value type
+		const int64_t Offset = clampValue(pos - reference.calculateDetent(Selection));
+		TEST_CHECK(filter.getDetentOffset((AnalogSelectorValue) pos) == Offset,
+			"[%lld, %lld] n %u dz %.2f at %lld: detent offset %lld, expected %lld",
+			(long long) rMin, (long long) rMax, n, dz, (long long) pos,
+			(long long) filter.getDetentOffset((AnalogSelectorValue) pos), (long long) Offset);
+
+		filter.getDetentLevel((AnalogSelectorValue) pos);  // only checked by the sanitizer
+	}
+}
+
+static void testEdgeCases() {
+	const int64_t Ranges[][2] = {
+		{ ValueMin, ValueMax },
+		{ INT16_MIN, INT16_MAX },
+		{ ValueMin, 0 },
+		{ 0, ValueMax },
+		{ ValueMin, ValueMin + 5 },
+		{ ValueMax - 3, ValueMax },
+		{ ValueMax, ValueMin },  // reversed
+		{ -1, 1 },
+		{ 0, 0 },
+		{ -8388608, 8388607 },   // 24-bit signed
+		{ 0, 16777215 },         // 24-bit unsigned
+		{ 0, 65535 },
+	};
+
+	for (const auto& range : Ranges) {
+		if (clampValue(range[0]) != range[0] || clampValue(range[1]) != range[1]) continue;  // too wide for the type
+
+		for (unsigned int n = 1; n <= 121; n += 4) {
+			for (int d = 0; d <= 10; d += 2) {
+				testAgainstReference(range[0], range[1], n, d / 10.0f, 2000);
+			}
+		}
+	}
+}
+
+static void testRandomRanges() {
+	for (int i = 0; i < 3000; i++) {
+		const int64_t A = randomIn(ValueMin, ValueMax);
+		const int64_t B = randomIn(ValueMin, ValueMax);
+		testAgainstReference(A, B, 1 + rng() % 200, (rng() % 101) / 100.0f, 2000);
+	}
+}
+
+// Sweeps through every input of the full 16-bit range. The selection only
+// moves in the direction of the input and the bounds always contain it.
+static void testFullSweeps() {
+	for (unsigned int n = 1; n <= 64; n += 7) {
+		for (int d = 0; d <= 4; d += 2) {
+			AnalogSelectorFilter filter(INT16_MIN, INT16_MAX, n, d / 4.0f);
+			unsigned int last = 0;
+
+			for (int32_t pos = INT16_MIN; pos <= INT16_MAX; pos++) {
+				const unsigned int Selection = filter.getPosition(pos);
+				TEST_CHECK(Selection >= last && pos >= filter.getLowerEdge() && pos <= filter.getUpperEdge(), "n %u dz %d/4 up at %d", n, d, (int) pos);
+				last = Selection;
+			}
+			TEST_CHECK(last == n - 1, "n %u dz %d/4 ended the sweep up at %u", n, d, last);
+
+			for (int32_t pos = INT16_MAX; pos >= INT16_MIN; pos--) {
+				const unsigned int Selection = filter.getPosition(pos);
+				TEST_CHECK(Selection <= last && pos >= filter.getLowerEdge() && pos <= filter.getUpperEdge(), "n %u dz %d/4 down at %d", n, d, (int) pos);
+				last = Selection;
+			}
+			TEST_CHECK(last == 0, "n %u dz %d/4 ended the sweep down at %u", n, d, last);
+		}
+	}
+}
+
+// classify() gives the position when the input selects the same one from
+// either direction, and the deadzone between them when it doesn't
+static void testClassify(int64_t rMin, int64_t rMax, int samples) {
+	for (unsigned int n = 1; n <= 24; n += 3) {
+		for (int d = 0; d <= 10; d += 2) {
+			const float Deadzone = d / 10.0f;
+			AnalogSelectorFilter filter((AnalogSelectorValue) rMin, (AnalogSelectorValue) rMax, n, Deadzone);
+			ReferenceFilter reference(rMin, rMax, n, Deadzone);
+
+			for (int i = 0; i < samples; i++) {
+				const int64_t Pos = (i < 2) ? ((i == 0) ? rMin : rMax) : randomIn(rMin, rMax);
+
+				reference.getPosition(rMin);
+				const unsigned int Up = reference.getPosition(Pos);
+				reference.getPosition(rMax);
+				const unsigned int Down = reference.getPosition(Pos);
+				const unsigned int Expected = (Up == Down) ? 2 * Up : 2 * Up + 1;
+
+				const unsigned int Class = filter.classify((AnalogSelectorValue) Pos);
+				TEST_CHECK(Class == Expected, "[%lld, %lld] n %u dz %.1f at %lld: class %u, expected %u",
+					(long long) rMin, (long long) rMax, n, Deadzone, (long long) Pos, Class, Expected);
+			}
+		}
+	}
+}
+
+// The block functions give the same results as the single sample ones
+static void testBlocks() {
+	AnalogSelectorValue input[4096];
+	int16_t narrow[4096];
+	for (size_t i = 0; i < 4096; i++) {
+		narrow[i] = (int16_t) randomIn(INT16_MIN, INT16_MAX);
+		input[i] = narrow[i];
+	}
+
+	AnalogSelectorFilter blockFilter(INT16_MIN, INT16_MAX, 13, 0.3f);
+	AnalogSelectorFilter singleFilter(INT16_MIN, INT16_MAX, 13, 0.3f);
+
+	unsigned int positions[4096];
+	uint16_t classes[4096];
+	blockFilter.getPositions(input, 4096, positions);
+	blockFilter.classify(narrow, 4096, classes);
+
+	for (size_t i = 0; i < 4096; i++) {
+		TEST_CHECK(positions[i] == singleFilter.getPosition(input[i]), "block position %u", (unsigned int) i);
+		TEST_CHECK(classes[i] == singleFilter.classify(input[i]), "block class %u", (unsigned int) i);
+	}
+}
+
+// With more positions than steps in the range the lower positions are still
+// reachable, rather than every input selecting the last one
+static void testTooManyPositions() {
+	for (unsigned int n = 11; n <= 30; n++) {
+		AnalogSelectorFilter filter(0, 10, n, 0.5f);
+		unsigned int last = 0;
+
+		for (int pos = 0; pos <= 10; pos++) {
+			const unsigned int Selection = filter.getPosition(pos);
+			TEST_CHECK(Selection >= last && Selection < n, "n %u up at %d: %u", n, pos, Selection);
+			last = Selection;
+		}
+		TEST_CHECK(last >= 9, "n %u ended the sweep up at %u", n, last);
+
+		for (int pos = 10; pos >= 0; pos--) {
+			const unsigned int Selection = filter.getPosition(pos);
+			TEST_CHECK(Selection <= last, "n %u down at %d: %u", n, pos, Selection);
+			last = Selection;
+		}
+		TEST_CHECK(last == 0, "n %u ended the sweep down at %u", n, last);
+	}
+}
+
+int main() {
+	testEdgeCases();
+	testRandomRanges();
+	testFullSweeps();
+	testClassify(0, 1023, 1024);
+	testClassify(INT16_MIN, INT16_MAX, 4000);
+	testClassify(ValueMin, ValueMax, 4000);
+	testBlocks();
+	testTooManyPositions();
+
+	printf("%u-bit values, ", (unsigned int) sizeof(AnalogSelectorValue) * 8);
+	return testReport("WideRangeTest");
+}
@@ -26,31 +26,147 @@
 
 #include "AnalogSelector.h"
 
+#include <math.h>
+
 #ifdef ARDUINO
 #include <Arduino.h>
 #endif
 
+#ifdef __AVR__
+#include <avr/sleep.h>
+#include "AnalogSelectorSleep.h"
+
+// ADC noise reduction sampling is supported on parts where the ADC reference
+// is set by the top two bits of ADMUX, which covers the ATmega boards
+#if defined(SLEEP_MODE_ADC) && defined(ADMUX) && defined(REFS0) && (REFS0 == 6) && !defined(REFS2)
+#define ANALOG_SELECTOR_ADC_SLEEP
+#endif
+#endif
+
+#ifdef ANALOG_SELECTOR_STATS
+#define ANALOG_SELECTOR_STAT(counter) (this->stats.counter++)
+#else
+#define ANALOG_SELECTOR_STAT(counter)
+#endif
+
+
+// Calculates the reciprocal of 'd' for use with divideByReciprocal(). This is
+// the 32-bit fixed point value ceil(2^32 / d), which is exact for any 16-bit
+// dividend as long as the divisor is also 16 bits.
+static uint32_t calculateReciprocal(unsigned int d) {
+	if (d <= 1 || d > 0xFFFF) return 0;  // not used, see below
+	return (0xFFFFFFFFUL / d) + 1;
+}
+
+// Divides 'n' by 'd' using a precomputed reciprocal from calculateReciprocal().
+// The product is split into two 16x16 multiplies, which are much faster than a
+// software division on 8-bit platforms.
+static AnalogSelectorSpan divideByReciprocal(AnalogSelectorSpan n, unsigned int d, uint32_t reciprocal) {
+	if (d <= 1) return (d == 1) ? n : 0;
+	if (n > 0xFFFF || d > 0xFFFF) return n / d;  // out of range for the reciprocal
+
+	const uint32_t High = (uint32_t) ((uint16_t) n) * (uint16_t) (reciprocal >> 16);
+	const uint32_t Low  = ((uint32_t) ((uint16_t) n) * (uint16_t) reciprocal) >> 16;
+
+	return (High + Low) >> 16;
+}
+
 
-AnalogSelectorFilter::AnalogSelectorFilter(int rMin, int rMax, unsigned int numPos, float dz)
+AnalogSelectorFilter::AnalogSelectorFilter(AnalogSelectorValue rMin, AnalogSelectorValue rMax, unsigned int numPos, float dz)
+	: numPositions(0), circular(false), reciprocalsValid(false), cache(nullptr),
+	  edgeLow(rMin), currentSelection(0), edgeHigh(rMin),
+	  detentCenter(rMin)  // initial selection is bottom of the range
+#ifdef ANALOG_SELECTOR_TRACE
+	, traceSink(nullptr)
+#endif
 {
-	setRange(rMin, rMax);
-	setNumPositions(numPos);
-	setDeadzone(dz);
+	configure(rMin, rMax, numPos, dz);
 
-	this->getPosition(rMin);  // initial selection is bottom of the range
+#ifdef ANALOG_SELECTOR_STATS
+	resetStats();
+#endif
 }
 
-unsigned int AnalogSelectorFilter::getPosition(int pos) {
+unsigned int AnalogSelectorFilter::updatePosition(AnalogSelectorValue pos) {
 	const bool relative = !this->configChanged;
 	if (this->configChanged) recalculateWidths();
 
 	return calculateSelection(pos, relative);
 }
 
-void AnalogSelectorFilter::setRange(int rMin, int rMax) {
+void AnalogSelectorFilter::getPositions(const AnalogSelectorValue* input, size_t count, unsigned int* output) {
+	for (size_t i = 0; i < count; i++) {
+		output[i] = this->getPosition(input[i]);
+	}
+}
+
+void AnalogSelectorFilter::getPositions(const int16_t* input, size_t count, size_t stride, unsigned int* output) {
+	for (size_t i = 0; i < count; i++) {
+		output[i] = this->getPosition(*input);
+		input += stride;
+	}
+}
+
+unsigned int AnalogSelectorFilter::classify(AnalogSelectorValue pos) const {
+	if (pos < this->rangeMin) pos = this->rangeMin;
+	else if (pos > this->rangeMax) pos = this->rangeMax;
+
+	const AnalogSelectorSpan Pitch = this->selectorWidth + this->deadzoneWidth;
+	const AnalogSelectorSpan Offset = (AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->rangeMin;
+
+	// with no room for the positions, everything past the bottom depends on
+	// the previous selection (see calculateSelectionUp/Down)
+	if (Pitch == 0) return (Offset == 0 || this->numPositions == 1) ? 0 : 1;
+
+	// in circular mode the deadzone between the last and first positions
+	// runs up to the top of the range and includes the bottom
+	if (this->circular && this->numPositions > 1) {
+		const AnalogSelectorSpan Top = (AnalogSelectorSpan) this->rangeMax - (AnalogSelectorSpan) this->rangeMin;
+		if (Offset == 0 || Offset > Top - this->deadzoneWidth) return this->numPositions * 2 - 1;
+	}
+
+	// position 'i' is selected from either direction between its lower edge
+	// plus the deadzone and its upper edge minus the deadzone. Measured from
+	// the end of the first selector, each deadzone is at the start of the
+	// pitch above it, so the remainder is within the deadzone width.
+	if (Offset < this->selectorWidth) return 0;
+
+	const AnalogSelectorSpan Shifted = Offset - this->selectorWidth;
+	const AnalogSelectorSpan Steps = Shifted / Pitch;
+
+	if (Steps + 1 >= this->numPositions) return (this->numPositions - 1) * 2;
+
+	const unsigned int i = Steps + 1;
+	if (Shifted - (Steps * Pitch) <= this->deadzoneWidth) return i * 2 - 1;
+	return i * 2;
+}
+
+void AnalogSelectorFilter::classify(const int16_t* input, size_t count, uint16_t* output) const {
+#ifdef _OPENMP
+	#pragma omp parallel for
+#endif
+	for (size_t i = 0; i < count; i++) {
+		output[i] = this->classify(input[i]);
+	}
+}
+
+void AnalogSelectorFilter::configure(AnalogSelectorValue rMin, AnalogSelectorValue rMax, unsigned int numPos, float dz) {
+	// the center of the current selection is our best guess at where the
+	// input is, so the new selection is wherever that lands in the new layout
+	const AnalogSelectorValue Previous = this->detentCenter;
+
+	setRange(rMin, rMax);
+	setNumPositions(numPos);
+	setDeadzone(dz);
+
+	recalculateWidths();
+	calculateSelection(Previous, false);
+}
+
+void AnalogSelectorFilter::setRange(AnalogSelectorValue rMin, AnalogSelectorValue rMax) {
 	// swap these if they're reversed
 	if (rMax < rMin) {
-		const int temp = rMin;
+		const AnalogSelectorValue temp = rMin;
 		rMin = rMax;
 		rMax = temp;
 	}
@@ -63,6 +179,7 @@ void AnalogSelectorFilter::setRange(int rMin, int rMax) {
 
 void AnalogSelectorFilter::setNumPositions(unsigned int numPos) {
 	if (numPos == 0) numPos = 1;  // can't have 0 segments
+	if (numPos != this->numPositions) this->reciprocalsValid = false;
 	this->numPositions = numPos;
 	this->configChanged = true;
 }
@@ -76,168 +193,951 @@ void AnalogSelectorFilter::setDeadzone(float dz) {
 	this->configChanged = true;
 }
 
-int AnalogSelectorFilter::calculateEdge(unsigned int i, Direction dir) const {
-	if (i < 0) i = 0;
+void AnalogSelectorFilter::setCircular(bool circular) {
+	if (circular == this->circular) return;
+
+	this->circular = circular;
+	this->configChanged = true;
+}
+
+unsigned int AnalogSelectorFilter::getSelection() const {
+	return this->currentSelection;
+}
+
+AnalogSelectorValue AnalogSelectorFilter::getRangeMin() const {
+	return this->rangeMin;
+}
+
+AnalogSelectorValue AnalogSelectorFilter::getRangeMax() const {
+	return this->rangeMax;
+}
+
+unsigned int AnalogSelectorFilter::getNumPositions() const {
+	return this->numPositions;
+}
+
+float AnalogSelectorFilter::getDeadzone() const {
+	return this->deadzoneSize;
+}
+
+bool AnalogSelectorFilter::isCircular() const {
+	return this->circular;
+}
+
+AnalogSelectorSpan AnalogSelectorFilter::getCircumference() const {
+	// the range is never reversed, so the unsigned difference is exact even
+	// if it's too wide for the signed type
+	const AnalogSelectorSpan Span = (AnalogSelectorSpan) this->rangeMax - (AnalogSelectorSpan) this->rangeMin;
+
+	// include the step from the top back to the bottom, unless the range is
+	// the entire type and that would wrap to 0
+	return (Span != (AnalogSelectorSpan) -1) ? Span + 1 : Span;
+}
+
+void AnalogSelectorFilter::setCache(AnalogSelectorCacheBase* cache) {
+	this->cache = cache;
+}
+
+AnalogSelectorValue AnalogSelectorFilter::getLowerEdge() const {
+	return this->edgeLow;
+}
+
+AnalogSelectorValue AnalogSelectorFilter::getUpperEdge() const {
+	return this->edgeHigh;
+}
+
+AnalogSelectorValue AnalogSelectorFilter::getDetentOffset(AnalogSelectorValue pos) const {
+	// measured unsigned as a magnitude and a sign, so inputs far from the
+	// detent can't overflow
+	bool below = (pos < this->detentCenter);
+	AnalogSelectorSpan Offset = below ?
+		(AnalogSelectorSpan) this->detentCenter - (AnalogSelectorSpan) pos :
+		(AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->detentCenter;
+
+	// in circular mode the detent is the closest way around
+	if (this->circular) {
+		const AnalogSelectorSpan Circumference = this->getCircumference();
+		if (Offset > Circumference / 2 && Offset < Circumference) {
+			Offset = Circumference - Offset;
+			below = !below;
+		}
+	}
+
+	// saturate distances that don't fit in the signed type
+	const AnalogSelectorSpan Max = ((AnalogSelectorSpan) -1) >> 1;
+	if (below) return (Offset > Max) ? -(AnalogSelectorValue) Max - 1 : -(AnalogSelectorValue) Offset;
+	return (Offset > Max) ? (AnalogSelectorValue) Max : (AnalogSelectorValue) Offset;
+}
+
+uint8_t AnalogSelectorFilter::getDetentLevel(AnalogSelectorValue pos) const {
+	// the distance from a detent to the far side of the next deadzone
+	const AnalogSelectorSpan Distance = (this->selectorWidth / 2) + this->deadzoneWidth;
+
+	if (this->detentScale == 0) {
+		this->detentScale = (Distance > 1) ? ((Distance < 0xFF00U) ? (0xFF00U / Distance) : 1) : 0xFF00U;
+	}
+
+	// measured unsigned, so inputs far from the detent can't overflow
+	AnalogSelectorSpan Offset = (pos >= this->detentCenter) ?
+		(AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->detentCenter :
+		(AnalogSelectorSpan) this->detentCenter - (AnalogSelectorSpan) pos;
+
+	// in circular mode the detent is the closest way around
+	if (this->circular) {
+		const AnalogSelectorSpan Circumference = this->getCircumference();
+		if (Offset > Circumference / 2 && Offset < Circumference) Offset = Circumference - Offset;
+	}
+
+	uint32_t Scaled;
+	if (Distance > 0xFF00U) {
+		Scaled = Offset / (Distance / 255);  // too wide for the 8.8 scale
+	}
+	else if (Offset > 0xFFFFU) {
+		Scaled = 255;  // past the next deadzone
+	}
+	else {
+		Scaled = ((uint32_t) Offset * this->detentScale) >> 8;
+	}
+
+	return (Scaled >= 255) ? 0 : (255 - Scaled);
+}
+
+#ifdef ANALOG_SELECTOR_STATS
+const AnalogSelectorStats& AnalogSelectorFilter::getStats() const {
+	return this->stats;
+}
 
-	int edge;
+void AnalogSelectorFilter::resetStats() {
+	this->stats = AnalogSelectorStats();
+}
+#endif
+
+#ifdef ANALOG_SELECTOR_TRACE
+void AnalogSelectorFilter::setTraceSink(AnalogSelectorTraceSink* sink) {
+	this->traceSink = sink;
+}
+#endif
+
+AnalogSelectorValue AnalogSelectorFilter::calculateEdge(unsigned int i, Direction dir) const {
+	ANALOG_SELECTOR_STAT(edgeEvaluations);
+
+	// the edges are calculated as unsigned offsets from the bottom of the
+	// range, which can't overflow even if the range is wider than the signed
+	// type can represent
+	const AnalogSelectorSpan TotalRange = (AnalogSelectorSpan) this->rangeMax - (AnalogSelectorSpan) this->rangeMin;
+	AnalogSelectorSpan offset;
 
 	if (dir == Direction::Upper) {
-		edge = this->rangeMin + (this->selectorWidth * (i + 1)) + (this->deadzoneWidth * (i != this->numPositions ? i+1 : i));
+		// the last position extends to the top of the range, covering any
+		// leftover from rounding the widths down
+		if (i + 1 >= this->numPositions) offset = TotalRange;
+		else offset = (this->selectorWidth * (i + 1)) + (this->deadzoneWidth * (i + 1));
 	}
 
 	else if (dir == Direction::Lower) {
-		edge = this->rangeMin + (this->selectorWidth * i) + (this->deadzoneWidth * (i != 0 ? i - 1 : i));
+		offset = (this->selectorWidth * i) + (this->deadzoneWidth * (i != 0 ? i - 1 : i));
 	}
 
 	else {
-		edge = this->rangeMin;  // should never occur, but guarding against '-Wmaybe-uninitialized'
+		offset = 0;  // should never occur, but guarding against '-Wmaybe-uninitialized'
 	}
 
-	if (edge < this->rangeMin) edge = this->rangeMin;
-	if (edge > this->rangeMax) edge = this->rangeMax;
+	if (offset > TotalRange) offset = TotalRange;
+
+	const AnalogSelectorValue edge = (AnalogSelectorValue) ((AnalogSelectorSpan) this->rangeMin + offset);
 
 	return edge;
 }
 
+unsigned int AnalogSelectorFilter::calculateSelectionUp(AnalogSelectorValue pos) const {
+	const AnalogSelectorSpan Pitch = this->selectorWidth + this->deadzoneWidth;
+	const AnalogSelectorSpan Offset = (AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->rangeMin;
+
+	// the upper edge of position 'i' is (rangeMin + Pitch * (i + 1)), so the
+	// first position with its edge at or above the input is ceil(Offset / Pitch) - 1
+	if (Offset == 0) return 0;
+	if (Pitch == 0) return this->numPositions - 1;
+
+	const AnalogSelectorSpan i = (Offset - 1) / Pitch;
+	return (i < this->numPositions) ? i : this->numPositions - 1;
+}
+
+unsigned int AnalogSelectorFilter::calculateSelectionDown(AnalogSelectorValue pos) const {
+	const AnalogSelectorSpan Pitch = this->selectorWidth + this->deadzoneWidth;
+	const AnalogSelectorSpan Offset = (AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->rangeMin;
+
+	// the lower edge of position 'i' is (rangeMin + Pitch * i - deadzoneWidth),
+	// so the last position with its edge at or below the input is
+	// floor((Offset + deadzoneWidth) / Pitch). That's measured from the end
+	// of the first selector so the sum can't overflow at the top of the range.
+	if (Pitch == 0 || Offset < this->selectorWidth) return 0;
+
+	const AnalogSelectorSpan i = (Offset - this->selectorWidth) / Pitch + 1;
+	return (i < this->numPositions) ? i : this->numPositions - 1;
+}
+
 void AnalogSelectorFilter::recalculateWidths() {
+	// Check the cache before calculating
+	// --------------------------------
+	AnalogSelectorLayout layout;
+	layout.rangeMin = this->rangeMin;
+	layout.rangeMax = this->rangeMax;
+	layout.numPositions = this->numPositions;
+	layout.deadzoneSize = this->deadzoneSize;
+	layout.circular = this->circular;
+
+	if (this->cache != nullptr && this->cache->find(layout)) {
+		this->selectorWidth = layout.selectorWidth;
+		this->deadzoneWidth = layout.deadzoneWidth;
+		ANALOG_SELECTOR_STAT(cacheHits);
+	}
+	else {
+		calculateWidths();
+
+		if (this->cache != nullptr) {
+			layout.selectorWidth = this->selectorWidth;
+			layout.deadzoneWidth = this->deadzoneWidth;
+			this->cache->store(layout);
+			ANALOG_SELECTOR_STAT(cacheMisses);
+		}
+	}
+
+	// Clear the config flag and continue
+	// --------------------------------
+	this->configChanged = false;
+	this->detentScale = 0;  // recalculated on use
+
+#ifdef ANALOG_SELECTOR_TRACE
+	if (this->traceSink != nullptr) {
+		AnalogSelectorTraceRecord record;
+		record.type = AnalogSelectorTraceRecord::Config;
+		record.flags = 0;
+		record.index = this->numPositions;
+		record.data[0] = this->rangeMin;
+		record.data[1] = this->rangeMax;
+		record.data[2] = this->selectorWidth;
+		record.data[3] = this->deadzoneWidth;
+		this->traceSink->write(record);
+	}
+#endif
+}
+
+void AnalogSelectorFilter::calculateWidths() {
+	// the widths are divided by the number of positions and the number of
+	// deadzones. These only change with the number of positions, so the
+	// reciprocals are kept until it does.
+	if (!this->reciprocalsValid) {
+		this->positionsReciprocal = calculateReciprocal(this->numPositions);
+		this->deadzonesReciprocal = calculateReciprocal(this->numPositions - 1);
+		this->reciprocalsValid = true;
+	}
+
 	// the total available range in the user scale
-	const unsigned int TotalRange = abs(rangeMax - rangeMin);
+	// the range is never reversed, so the unsigned difference is exact even
+	// if it's too wide for the signed type. A circular range includes the
+	// step from the top back to the bottom.
+	const AnalogSelectorSpan TotalRange = this->circular ? this->getCircumference() :
+		(AnalogSelectorSpan) this->rangeMax - (AnalogSelectorSpan) this->rangeMin;
 
 	// Deadzone calculations first
 	// --------------------------------
 
 	// saving (1 * numPositions) for a minimum active area, so we don't
-	// have 100% deadzone at the limits
-	const unsigned int DeadzoneRange = TotalRange - numPositions;
+	// have 100% deadzone at the limits. Circular ranges save (2 * numPositions),
+	// as every position has a deadzone on both sides.
+	const AnalogSelectorSpan MinimumRange = this->circular ? 2 * (AnalogSelectorSpan) this->numPositions : this->numPositions;
+	const AnalogSelectorSpan DeadzoneRange = (TotalRange > MinimumRange) ? (TotalRange - MinimumRange) : 0;
 
-	// accounting for deadzones between every position with none at the ends
-	const unsigned int NumDeadzones = (this->numPositions) - 1;
+	// accounting for deadzones between every position with none at the ends,
+	// or with one more between the ends if the range is circular
+	const unsigned int NumDeadzones = this->circular ? this->numPositions : this->numPositions - 1;
+	const uint32_t DeadzonesReciprocal = this->circular ? this->positionsReciprocal : this->deadzonesReciprocal;
 
 	// the absolute limit for a deadzone, assuming a deadzone size of 1.0
-	const unsigned int MaxDeadzoneWidth = (NumDeadzones != 0) ? (DeadzoneRange / NumDeadzones) : 0;
+	const AnalogSelectorSpan MaxDeadzoneWidth = divideByReciprocal(DeadzoneRange, NumDeadzones, DeadzonesReciprocal);
 
-	// the width of each deadzone segment, in the units of the range
-	this->deadzoneWidth = (float)MaxDeadzoneWidth * this->deadzoneSize;
+	// the width of each deadzone segment, in the units of the range. A float
+	// can round up past the maximum for wide ranges, so that's clamped.
+	const float DeadzoneWidth = (float)MaxDeadzoneWidth * this->deadzoneSize;
+	this->deadzoneWidth = (DeadzoneWidth < (float)MaxDeadzoneWidth) ? (AnalogSelectorSpan)DeadzoneWidth : MaxDeadzoneWidth;
 
 	// Selection calculations second
 	// --------------------------------
 
 	// the total selector range is the area that is left after the deadzone cals
-	const unsigned long SelectorRange = TotalRange - (this->deadzoneWidth * NumDeadzones);
+	const AnalogSelectorSpan SelectorRange = TotalRange - (this->deadzoneWidth * NumDeadzones);
 
 	// the width of each selector segment is the selector range divided by the number of positions
-	this->selectorWidth = SelectorRange / this->numPositions;
+	this->selectorWidth = divideByReciprocal(SelectorRange, this->numPositions, this->positionsReciprocal);
 
-	// Clear the config flag and continue
-	// --------------------------------
-	this->configChanged = false;
+	// with more positions than steps in the range the width rounds down to
+	// 0, which would leave every input in the last position. The edges are
+	// clamped to the range, so at least the lower positions stay reachable.
+	// (A circular range only gets here if the positions can't fit at all.)
+	if (this->selectorWidth == 0 && !this->circular) this->selectorWidth = 1;
+}
 
-#if 0
-	Print& output = Serial;
+unsigned int AnalogSelectorFilter::calculateSelection(AnalogSelectorValue pos, bool relative) {
+	if (this->circular) return calculateCircularSelection(pos, relative);
 
-	output.println("Recalculating...");
+	     if (pos < rangeMin) pos = rangeMin;
+	else if (pos > rangeMax) pos = rangeMax;
 
-	output.print("Range Min: ");
-	output.println(this->rangeMin);
-	output.print("Range Max: ");
-	output.println(this->rangeMax);
-	output.print("Total Range: ");
-	output.println(TotalRange);
+	ANALOG_SELECTOR_STAT(samples);
 
-	output.print("Deadzone Width: ");
-	output.println(this->deadzoneWidth);
-	output.print("Selector Range: ");
-	output.println(this->selectorWidth);
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+	const unsigned int PreviousSelection = this->currentSelection;
+#endif
 
-	output.println("Edges:");
-	for (unsigned int i = 0; i < this->numPositions; i++) {
-		output.print("S"); output.print(i); output.print(" ");
-		output.print(this->calculateEdge(i, Direction::Lower));
-		output.print(" - ");
-		output.print(this->calculateEdge(i, Direction::Upper));
-		output.println();
+#ifdef ANALOG_SELECTOR_STATS
+	     if (!relative) ANALOG_SELECTOR_STAT(absoluteScans);
+	else if (pos > edgeHigh || pos < edgeLow) ANALOG_SELECTOR_STAT(relativeScans);
+#endif
+
+	// if we're not using relative positioning, or if we're above the upper bound,
+	// the selection is the lowest one whose upper edge is at or above the input
+	//
+	// if we're below the lower bound, the selection is the highest one whose
+	// lower edge is at or below the input
+	//
+	// both are calculated directly from the input, so the cost doesn't depend
+	// on the number of positions or how far the input has moved
+	if (!relative || pos > edgeHigh || pos < edgeLow) {
+		const unsigned int Selection = (!relative || pos > edgeHigh) ? calculateSelectionUp(pos) : calculateSelectionDown(pos);
+
+		this->currentSelection = Selection;
+		this->edgeLow = calculateEdge(Selection, Direction::Lower);
+		this->edgeHigh = calculateEdge(Selection, Direction::Upper);
+
+		// the detent is the center of the selection without its deadzones,
+		// which the first and last positions don't have on their outer sides
+		// (using unsigned math, as the deadzones can be wider than the signed type)
+		const AnalogSelectorSpan DetentLow  = (AnalogSelectorSpan) this->edgeLow  + ((Selection > 0) ? this->deadzoneWidth : 0);
+		const AnalogSelectorSpan DetentHigh = (AnalogSelectorSpan) this->edgeHigh - ((Selection + 1 < this->numPositions) ? this->deadzoneWidth : 0);
+		this->detentCenter = (AnalogSelectorValue) (DetentLow + (AnalogSelectorSpan) (DetentHigh - DetentLow) / 2);
 	}
+
+	// if we're inside the bounds we haven't changed
+	else {}
+
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+	this->recordSelection(pos, relative, PreviousSelection,
+		(AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->edgeLow,
+		(AnalogSelectorSpan) this->edgeHigh - (AnalogSelectorSpan) this->edgeLow);
 #endif
 
+	return this->currentSelection;
 }
 
-unsigned int AnalogSelectorFilter::calculateSelection(int pos, bool relative) {
-	     if (pos < rangeMin) pos = rangeMin;
-	else if (pos > rangeMax) pos = rangeMax;
+unsigned int AnalogSelectorFilter::calculateCircularSelection(AnalogSelectorValue pos, bool relative) {
+	const AnalogSelectorSpan Circumference = this->getCircumference();
 
-	// if we're not using relative positioning, calculate from the bottom
-	// to the top starting from 0
-	//
-	// if we are using relative positioning, calculate going up if we're above the
-	// upper bound
-	if (!relative || pos > edgeHigh) {
-		int start = !relative ? 0 : this->currentSelection;
-
-		for (int i = start; i < (int) numPositions; i++) {
-			const int UpperEdge = calculateEdge(i, Direction::Upper);
-			if (pos > UpperEdge) continue;  // if we're above the upper edge we can't be in this selection
-		
-			// otherwise, we've found our selection! assign and quit
-			this->currentSelection = i;
-			this->edgeLow = calculateEdge(i, Direction::Lower);
-			this->edgeHigh = UpperEdge;
-			break;
+	// wrap the input into the range, as an offset from the bottom
+	AnalogSelectorSpan offset;
+	if (pos < this->rangeMin) {
+		offset = (AnalogSelectorSpan) ((AnalogSelectorSpan) this->rangeMin - (AnalogSelectorSpan) pos) % Circumference;
+		if (offset != 0) offset = Circumference - offset;
+	}
+	else {
+		offset = (AnalogSelectorSpan) pos - (AnalogSelectorSpan) this->rangeMin;
+		if (offset >= Circumference) offset %= Circumference;
+	}
+
+	ANALOG_SELECTOR_STAT(samples);
+
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+	const unsigned int PreviousSelection = this->currentSelection;
+#endif
+
+	// the layout is the same as the linear one, but each bound is a start
+	// and a length, which may cross the top of the range
+	const AnalogSelectorSpan Pitch = this->selectorWidth + this->deadzoneWidth;
+	const unsigned int Last = this->numPositions - 1;
+
+	CircularBound bound = this->calculateCircularBound(this->currentSelection, Circumference);
+
+	// distance of the input past the start of the current bound, going up
+	AnalogSelectorSpan into = (offset >= bound.start) ? offset - bound.start : offset + (Circumference - bound.start);
+
+	if (!relative || into > bound.length) {
+		// if the input is closer past the top of the bound it moved up,
+		// otherwise it moved down
+		const bool Up = !relative || (into - bound.length <= Circumference - into);
+
+#ifdef ANALOG_SELECTOR_STATS
+		     if (!relative) ANALOG_SELECTOR_STAT(absoluteScans);
+		else ANALOG_SELECTOR_STAT(relativeScans);
+#endif
+
+		// moving up, the selection is the lowest one whose upper edge is at or
+		// above the input. The top of the circle is also the bottom, where the
+		// upper edge of the last position is.
+		//
+		// moving down, the selection is the highest one whose lower edge is at
+		// or below the input. The lower edge of position 0 is in the deadzone
+		// below the top of the circle.
+		unsigned int selection;
+
+		if (Up) {
+			if (offset == 0 || Pitch == 0) selection = Last;
+			else selection = (offset - 1) / Pitch;
+		}
+		else {
+			if (offset >= Circumference - this->deadzoneWidth || Pitch == 0 || offset < this->selectorWidth) selection = 0;
+			else selection = (offset - this->selectorWidth) / Pitch + 1;
 		}
+		if (selection > Last) selection = Last;
+
+		this->currentSelection = selection;
+
+		bound = this->calculateCircularBound(selection, Circumference);
+		into = (offset >= bound.start) ? offset - bound.start : offset + (Circumference - bound.start);
+
+		// the edges are where the bound starts and ends, so the lower edge is
+		// above the upper edge if it crosses the top of the range
+		const AnalogSelectorSpan HoldEnd = Circumference - bound.start;  // distance to the top
+		this->edgeLow  = (AnalogSelectorValue) ((AnalogSelectorSpan) this->rangeMin + bound.start);
+		this->edgeHigh = (AnalogSelectorValue) ((AnalogSelectorSpan) this->rangeMin +
+			((bound.length < HoldEnd) ? bound.start + bound.length : bound.length - HoldEnd));
+
+		// the detent is the center of the selection without its deadzones,
+		// which every position has on both sides
+		const AnalogSelectorSpan Detent = this->deadzoneWidth + (AnalogSelectorSpan) (bound.length - 2 * this->deadzoneWidth) / 2;
+		this->detentCenter = (AnalogSelectorValue) ((AnalogSelectorSpan) this->rangeMin +
+			((Detent < HoldEnd) ? bound.start + Detent : Detent - HoldEnd));
 	}
 
-	// if below the lower limit, start calculating going downwards
-	else if (pos < edgeLow) {
-		for (int i = currentSelection; i >= 0; i--) {
-			const int LowerEdge = calculateEdge(i, Direction::Lower);
-			if (pos < LowerEdge) continue;
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+	this->recordSelection(pos, relative, PreviousSelection, into, bound.length);
+#endif
+
+	return this->currentSelection;
+}
+
+AnalogSelectorFilter::CircularBound AnalogSelectorFilter::calculateCircularBound(unsigned int i, AnalogSelectorSpan circumference) const {
+	const AnalogSelectorSpan Pitch = this->selectorWidth + this->deadzoneWidth;
+	const unsigned int Last = this->numPositions - 1;
+
+	// the bound starts in the deadzone below the position's selector area,
+	// which for position 0 is below the top of the circle
+	CircularBound bound;
+	bound.start = Pitch * i;
+	bound.start = (bound.start >= this->deadzoneWidth) ? bound.start - this->deadzoneWidth : bound.start + (circumference - this->deadzoneWidth);
+
+	// the last position takes whatever is left up to the top of the circle
+	bound.length = ((i < Last) ? Pitch : circumference - (Pitch * Last)) + this->deadzoneWidth;
+
+	return bound;
+}
 
-			this->currentSelection = i;
-			this->edgeLow = LowerEdge;
-			this->edgeHigh = calculateEdge(i, Direction::Upper);
-			break;
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+void AnalogSelectorFilter::recordSelection(AnalogSelectorValue pos, bool relative, unsigned int previous, AnalogSelectorSpan into, AnalogSelectorSpan length) {
+#ifdef ANALOG_SELECTOR_STATS
+	if (this->currentSelection != previous) ANALOG_SELECTOR_STAT(transitions);
+
+	// the deadzones are the parts of the current bound shared with a neighbor.
+	// On a circular range every position has a neighbor on both sides.
+	const bool SharedLow  = this->circular ? (this->numPositions > 1) : (this->currentSelection > 0);
+	const bool SharedHigh = this->circular ? (this->numPositions > 1) : (this->currentSelection + 1 < this->numPositions);
+
+	if (this->deadzoneWidth > 0) {
+		if ((SharedLow && into < this->deadzoneWidth) || (SharedHigh && length - into < this->deadzoneWidth)) {
+			ANALOG_SELECTOR_STAT(deadzoneSamples);
 		}
 	}
+#else
+	(void) into;
+	(void) length;
+#endif
+
+#ifdef ANALOG_SELECTOR_TRACE
+	if (this->traceSink != nullptr && this->currentSelection != previous) {
+		AnalogSelectorTraceRecord record;
+		record.type = AnalogSelectorTraceRecord::Selection;
+		record.flags = relative ? 1 : 0;
+		record.index = this->currentSelection;
+		record.data[0] = pos;
+		record.data[1] = this->edgeLow;
+		record.data[2] = this->edgeHigh;
+		record.data[3] = previous;
+		this->traceSink->write(record);
+	}
+#else
+	(void) pos;
+	(void) relative;
+#endif
+}
+#endif
 
-	// if we're inside the bounds we haven't changed
-	else {}
-	
-#if 0
-	Print& output = Serial;
 
-	output.print("Current Selection: ");
-	output.println(this->currentSelection);
+AnalogSelectorCacheBase::AnalogSelectorCacheBase(AnalogSelectorLayout* entries, uint8_t capacity)
+	: Entries(entries), Size(capacity), count(0), next(0)
+{}
 
-	output.print("New Lower Edge: ");
-	output.println(this->edgeLow);
+bool AnalogSelectorCacheBase::find(AnalogSelectorLayout& layout) {
+	for (uint8_t i = 0; i < this->count; i++) {
+		const AnalogSelectorLayout& entry = this->Entries[i];
 
-	output.print("New Upper Edge: ");
-	output.println(this->edgeHigh);
+		if (entry.rangeMin == layout.rangeMin && entry.rangeMax == layout.rangeMax &&
+			entry.numPositions == layout.numPositions && entry.deadzoneSize == layout.deadzoneSize &&
+			entry.circular == layout.circular)
+		{
+			layout.selectorWidth = entry.selectorWidth;
+			layout.deadzoneWidth = entry.deadzoneWidth;
+			return true;
+		}
+	}
+	return false;
+}
+
+void AnalogSelectorCacheBase::store(const AnalogSelectorLayout& layout) {
+	if (this->Size == 0) return;
+
+	this->Entries[this->next] = layout;
+	if (++this->next == this->Size) this->next = 0;
+	if (this->count < this->Size) this->count++;
+}
+
+void AnalogSelectorCacheBase::clear() {
+	this->count = 0;
+	this->next = 0;
+}
+
+
+BipolarAnalogSelectorFilter::BipolarAnalogSelectorFilter(AnalogSelectorValue rMin, AnalogSelectorValue center, AnalogSelectorValue rMax,
+	unsigned int stepsDown, unsigned int stepsUp, AnalogSelectorSpan centerWidth, float dz)
+	: lower(rMin, center, 1, dz), upper(center, rMax, 1, dz), selection(0)
+{
+	configure(rMin, center, rMax, stepsDown, stepsUp, centerWidth, dz);
+}
+
+void BipolarAnalogSelectorFilter::configure(AnalogSelectorValue rMin, AnalogSelectorValue center, AnalogSelectorValue rMax,
+	unsigned int stepsDown, unsigned int stepsUp, AnalogSelectorSpan centerWidth, float dz)
+{
+	// swap these if they're reversed, and keep the center inside the range
+	if (rMax < rMin) {
+		const AnalogSelectorValue temp = rMin;
+		rMin = rMax;
+		rMax = temp;
+	}
+
+	     if (center < rMin) center = rMin;
+	else if (center > rMax) center = rMax;
+
+	this->center = center;
+	this->stepsDown = stepsDown;
+	this->stepsUp = stepsUp;
+
+	// the center band is clipped to the range on each side, measured
+	// unsigned so that wide ranges can't overflow
+	const AnalogSelectorSpan HalfWidth = centerWidth / 2;
+	const AnalogSelectorSpan SpanDown = (AnalogSelectorSpan) center - (AnalogSelectorSpan) rMin;
+	const AnalogSelectorSpan SpanUp   = (AnalogSelectorSpan) rMax - (AnalogSelectorSpan) center;
+
+	const AnalogSelectorSpan BandDown = (HalfWidth < SpanDown) ? HalfWidth : SpanDown;
+	const AnalogSelectorSpan BandUp   = (HalfWidth < SpanUp)   ? HalfWidth : SpanUp;
+
+	// a side with no positions is part of the center band
+	this->bandLow  = (stepsDown > 0) ? (AnalogSelectorValue) ((AnalogSelectorSpan) center - BandDown) : rMin;
+	this->bandHigh = (stepsUp   > 0) ? (AnalogSelectorValue) ((AnalogSelectorSpan) center + BandUp)   : rMax;
+
+	// the sides start just outside of the center band, so inputs inside
+	// the band while a side is held are clipped to its closest position
+	this->lower.configure(rMin, (this->bandLow > rMin) ? this->bandLow - 1 : rMin, stepsDown, dz);
+	this->upper.configure((this->bandHigh < rMax) ? this->bandHigh + 1 : rMax, rMax, stepsUp, dz);
+
+	// the sides hold into the center band by the deadzone fraction of it
+	const float Deadzone = this->upper.getDeadzone();  // clipped by the filter
+	this->exitLow  = (AnalogSelectorValue) ((AnalogSelectorSpan) this->bandLow  + (AnalogSelectorSpan) ((float) BandDown * Deadzone));
+	this->exitHigh = (AnalogSelectorValue) ((AnalogSelectorSpan) this->bandHigh - (AnalogSelectorSpan) ((float) BandUp   * Deadzone));
+
+	this->selection = 0;
+}
+
+int BipolarAnalogSelectorFilter::updatePosition(AnalogSelectorValue pos) {
+	// a side entered from the center or the other side starts from its end
+	// next to the center, so that the input is treated as moving away from
+	// it and deadzones resolve toward the center rather than toward wherever
+	// the side was last left
+	if (pos < this->bandLow && this->stepsDown > 0) {
+		if (this->selection >= 0) this->lower.getPosition(this->lower.getRangeMax());
+		this->selection = (int) this->lower.getPosition(pos) - (int) this->stepsDown;
+	}
+	else if (pos > this->bandHigh && this->stepsUp > 0) {
+		if (this->selection <= 0) this->upper.getPosition(this->upper.getRangeMin());
+		this->selection = (int) this->upper.getPosition(pos) + 1;
+	}
+	else {
+		this->selection = 0;
+	}
+
+	return this->selection;
+}
+
+int BipolarAnalogSelectorFilter::getSelection() const {
+	return this->selection;
+}
+
+AnalogSelectorValue BipolarAnalogSelectorFilter::getCenter() const {
+	return this->center;
+}
+
+
+AnalogSelectorFilter2DBase::AnalogSelectorFilter2DBase(int16_t* boundaries, uint8_t numSectors,
+	AnalogSelectorValue cx, AnalogSelectorValue cy, AnalogSelectorSpan radius, float dz)
+	: Boundaries(boundaries), NumSectors(numSectors), selection(0)
+{
+	configure(cx, cy, radius, dz);
+}
+
+void AnalogSelectorFilter2DBase::configure(AnalogSelectorValue cx, AnalogSelectorValue cy, AnalogSelectorSpan radius, float dz) {
+	     if (dz < 0.0) dz = 0.0;
+	else if (dz > 1.0) dz = 1.0;
+
+	this->centerX = cx;
+	this->centerY = cy;
+
+	// Radial thresholds
+	// --------------------------------
+
+	// the squared radius has to fit in 32 bits, so the radius is limited
+	// to 46340 (about sqrt(2^31))
+	if (radius > 46340U) radius = 46340U;
+
+	// the input returns to the center at a smaller radius than it leaves
+	const float Inner = (float) radius * (1.0 - dz / 4);
+
+	this->radiusLimit = radius;
+	this->radiusEnter = (uint32_t) radius * radius;
+	this->radiusExit  = (uint32_t) (Inner * Inner);
+
+	// Angular boundaries
+	// --------------------------------
+
+	// sector 'k' is centered on (2 * pi * k / n), so its lower boundary is
+	// half a sector before that. This is the only place that needs trig.
+	const float SectorAngle = 2 * M_PI / this->NumSectors;
+
+	for (uint8_t k = 0; k < this->NumSectors; k++) {
+		const float Angle = SectorAngle * k - SectorAngle / 2;
+		this->Boundaries[k * 2]     = (int16_t) lround(cos(Angle) * 16384);
+		this->Boundaries[k * 2 + 1] = (int16_t) lround(sin(Angle) * 16384);
+	}
+
+	// each boundary is held past by up to a quarter of a sector
+	const float DeadzoneAngle = dz * SectorAngle / 4;
+	this->deadzoneCos = (int16_t) lround(cos(DeadzoneAngle) * 16384);
+	this->deadzoneSin = (int16_t) lround(sin(DeadzoneAngle) * 16384);
+
+	setSelection(0);
+}
+
+unsigned int AnalogSelectorFilter2DBase::getPosition(AnalogSelectorValue x, AnalogSelectorValue y) {
+	// the distances are measured unsigned, with the signs kept separately,
+	// so inputs far from the center can't overflow
+	const bool NegX = (x < this->centerX);
+	const bool NegY = (y < this->centerY);
+	uint32_t AbsX = NegX ? (uint32_t) this->centerX - (uint32_t) x : (uint32_t) x - (uint32_t) this->centerX;
+	uint32_t AbsY = NegY ? (uint32_t) this->centerY - (uint32_t) y : (uint32_t) y - (uint32_t) this->centerY;
+
+	// Radius check
+	// --------------------------------
+
+	// if either axis is past the radius the input is outside of the center,
+	// otherwise both are small enough to square
+	bool outside = true;
+
+	if (AbsX <= this->radiusLimit && AbsY <= this->radiusLimit) {
+		const uint32_t Radius = (AbsX * AbsX) + (AbsY * AbsY);
+
+		if (this->selection == 0) outside = (Radius > this->radiusEnter);
+		else outside = (Radius >= this->radiusExit);
+	}
+
+	if (!outside) {
+		if (this->selection != 0) setSelection(0);
+		return 0;
+	}
+
+	// Angle check
+	// --------------------------------
+
+	// the cross products are done in 32 bits, so the distances are reduced
+	// to 16 bits. This keeps the angle, which is all that matters here.
+	while (AbsX > 0x7FFF || AbsY > 0x7FFF) {
+		AbsX /= 2;
+		AbsY /= 2;
+	}
+
+	const int32_t dx = NegX ? -(int32_t) AbsX : (int32_t) AbsX;
+	const int32_t dy = NegY ? -(int32_t) AbsY : (int32_t) AbsY;
+
+	// the input stays in the current sector until it passes one of the
+	// boundaries by more than the deadzone
+	if (this->selection != 0) {
+		const int32_t AboveLow  = (int32_t) this->holdLow[0] * dy - (int32_t) this->holdLow[1] * dx;
+		const int32_t BelowHigh = (int32_t) this->holdHigh[1] * dx - (int32_t) this->holdHigh[0] * dy;
+		if (AboveLow >= 0 && BelowHigh >= 0) return this->selection;
+	}
+
+	setSelection(calculateSector(dx, dy));
+	return this->selection;
+}
+
+void AnalogSelectorFilter2DBase::getPositions(const AnalogSelectorValue* x, const AnalogSelectorValue* y, size_t count, unsigned int* output) {
+	for (size_t i = 0; i < count; i++) {
+		output[i] = this->getPosition(x[i], y[i]);
+	}
+}
+
+unsigned int AnalogSelectorFilter2DBase::calculateSector(int32_t dx, int32_t dy) const {
+	// the input is in sector 'k' if it's at or counter-clockwise of the lower
+	// boundary and clockwise of the upper boundary. Neighboring sectors share
+	// their boundaries, so exactly one matches.
+	for (uint8_t k = 0; k < this->NumSectors; k++) {
+		const int16_t* Low  = &this->Boundaries[k * 2];
+		const int16_t* High = &this->Boundaries[((k + 1 < this->NumSectors) ? k + 1 : 0) * 2];
+
+		const int32_t AboveLow  = (int32_t) Low[0] * dy - (int32_t) Low[1] * dx;
+		const int32_t BelowHigh = (int32_t) High[1] * dx - (int32_t) High[0] * dy;
+
+		if (AboveLow >= 0 && BelowHigh > 0) return k + 1;
+	}
+	return 1;  // should never occur
+}
+
+void AnalogSelectorFilter2DBase::setSelection(unsigned int sector) {
+	this->selection = sector;
+	if (sector == 0) return;
+
+	const int16_t* Low  = &this->Boundaries[(sector - 1) * 2];
+	const int16_t* High = &this->Boundaries[((sector < this->NumSectors) ? sector : 0) * 2];
+
+	// rotate the lower boundary clockwise and the upper boundary
+	// counter-clockwise by the deadzone angle, with rounding
+	const int32_t Cos = this->deadzoneCos;
+	const int32_t Sin = this->deadzoneSin;
+
+	this->holdLow[0]  = (int16_t) (((int32_t) Low[0] * Cos + (int32_t) Low[1] * Sin + 8192) >> 14);
+	this->holdLow[1]  = (int16_t) (((int32_t) Low[1] * Cos - (int32_t) Low[0] * Sin + 8192) >> 14);
+	this->holdHigh[0] = (int16_t) (((int32_t) High[0] * Cos - (int32_t) High[1] * Sin + 8192) >> 14);
+	this->holdHigh[1] = (int16_t) (((int32_t) High[1] * Cos + (int32_t) High[0] * Sin + 8192) >> 14);
+}
+
+unsigned int AnalogSelectorFilter2DBase::getSelection() const {
+	return this->selection;
+}
+
+uint8_t AnalogSelectorFilter2DBase::getNumSectors() const {
+	return this->NumSectors;
+}
+
+
+AnalogSelectorEma::AnalogSelectorEma(uint8_t shift)
+{
+	setShift(shift);
+}
+
+AnalogSelectorValue AnalogSelectorEma::process(AnalogSelectorValue value) {
+	// scaling by multiplication rather than shifting, which is undefined for
+	// negative values. With a constant this compiles to a shift anyway.
+	if (!this->seeded) {
+		this->accumulator = (Accumulator) value * ((Accumulator) 1 << this->shift);
+		this->seeded = true;
+		return value;
+	}
+
+	// both the update and the output use the rounded average, so a constant
+	// input settles on exactly that value without any bias
+	const Accumulator Half = ((Accumulator) 1 << this->shift) >> 1;
+	const Accumulator Average = (this->accumulator + Half) >> this->shift;
+
+	this->accumulator += value - Average;
+
+	return (AnalogSelectorValue) ((this->accumulator + Half) >> this->shift);
+}
+
+void AnalogSelectorEma::setShift(uint8_t shift) {
+	if (shift > 15) shift = 15;  // leaves room for the input in the accumulator
+	this->shift = shift;
+	reset();
+}
+
+uint8_t AnalogSelectorEma::getShift() const {
+	return this->shift;
+}
+
+void AnalogSelectorEma::reset() {
+	this->accumulator = 0;
+	this->seeded = false;
+}
+
+
+#ifdef ANALOG_SELECTOR_ADC_SLEEP
+// Empty handler for the ADC interrupt, which wakes the CPU from noise
+// reduction sleep. This is weak so that it can be replaced by a sketch that
+// needs its own ADC interrupt.
+ISR(ADC_vect, __attribute__((weak))) {}
+
+// Power controller for AnalogSelectorSleep, using the AVR registers
+struct AvrAdcPower {
+	uint8_t saveInterrupts() { return SREG; }
+	void restoreInterrupts(uint8_t state) { SREG = state; }
+	void enableInterrupts() { sei(); }
+	void disableInterrupts() { cli(); }
+
+	void beginSleep() {
+		ADCSRA |= _BV(ADIE);
+		set_sleep_mode(SLEEP_MODE_ADC);
+		sleep_enable();
+	}
+
+	void sleep() { sleep_cpu(); }
+	bool converting() { return bit_is_set(ADCSRA, ADSC); }
+
+	void endSleep() {
+		sleep_disable();
+		ADCSRA &= ~_BV(ADIE);
+	}
+
+	int result() { return ADC; }
+};
+
+static int analogReadSleep(uint8_t pin) {
+	// convert the pin number to a channel, matching analogRead()
+#if defined(analogPinToChannel)
+#if defined(__AVR_ATmega32U4__)
+	if (pin >= 18) pin -= 18;
+#endif
+	pin = analogPinToChannel(pin);
+#elif defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+	if (pin >= 54) pin -= 54;
+#elif defined(__AVR_ATmega32U4__)
+	if (pin >= 18) pin -= 18;
+#elif defined(__AVR_ATmega1284__) || defined(__AVR_ATmega1284P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644A__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega644PA__)
+	if (pin >= 24) pin -= 24;
+#else
+	if (pin >= 14) pin -= 14;
 #endif
 
-	return this->currentSelection;
+#if defined(ADCSRB) && defined(MUX5)
+	ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+#endif
+	ADMUX = (ADMUX & 0xC0) | (pin & 0x07);  // keep the reference bits from analogRead()
+
+	AvrAdcPower power;
+	return AnalogSelectorSleep<AvrAdcPower>::convert(power);
 }
+#endif
 
+#ifdef ARDUINO
+AnalogSelector::ClockFunction AnalogSelector::Clock = micros;
+#else
+AnalogSelector::ClockFunction AnalogSelector::Clock = nullptr;
+#endif
 
 AnalogSelector::AnalogSelector(unsigned int pin, unsigned int numPos, int rMin, int rMax)
-	: filter(rMin, rMax, numPos, 0.2), Pin(pin)
+	: filter(rMin, rMax, numPos, 0.2), Pin(pin), sampleInterval(0), lastSample(0),
+	lastReading(rMin), backoff(0), maxBackoff(0), noiseReduction(false), smoothing(0)
 {}
 
 void AnalogSelector::begin() {
 #ifdef ARDUINO
 	pinMode(this->Pin, INPUT);
 #endif
-	this->getPosition();  // set initial position
+	this->sample();  // set initial position
 }
 
 unsigned int AnalogSelector::getPosition() {
+	if (this->sampleInterval != 0 && Clock != nullptr) {
+		// the backed off interval saturates rather than wrapping to a shorter one
+		const unsigned long Limit = ~0UL >> this->backoff;
+		const unsigned long interval = (this->sampleInterval > Limit) ? ~0UL : (this->sampleInterval << this->backoff);
+
+		const unsigned long now = Clock();
+		if (now - this->lastSample < interval) {
+			return this->filter.getSelection();  // too soon, use the last result
+		}
+	}
+
+	return this->sample();
+}
+
+#ifdef ARDUINO
+// Gives the distance going up from one input to another on a circular
+// range (0 - circumference). Measured unsigned, so it can't overflow.
+static AnalogSelectorSpan wrapDistance(int from, int to, AnalogSelectorSpan circumference) {
+	if (to >= from) return (AnalogSelectorSpan) ((AnalogSelectorSpan) to - (AnalogSelectorSpan) from) % circumference;
+
+	const AnalogSelectorSpan Back = (AnalogSelectorSpan) ((AnalogSelectorSpan) from - (AnalogSelectorSpan) to) % circumference;
+	return (Back != 0) ? circumference - Back : 0;
+}
+#endif
+
+unsigned int AnalogSelector::sample() {
+	if (Clock != nullptr) this->lastSample = Clock();
+
 #ifdef ARDUINO
-	const int reading = analogRead(this->Pin);
-	return this->filter.getPosition(reading);
+#ifdef ANALOG_SELECTOR_ADC_SLEEP
+	const int raw = this->noiseReduction ? analogReadSleep(this->Pin) : analogRead(this->Pin);
+#else
+	const int raw = analogRead(this->Pin);
+#endif
+	const int reading = this->smoothing.process(raw);
+	const unsigned int selection = this->filter.getPosition(reading);
+
+	if (this->maxBackoff != 0) {
+		const int lower = this->filter.getLowerEdge();
+		const int upper = this->filter.getUpperEdge();
+
+		// 'near' is within a quarter of the current selection's width of an
+		// edge shared with another selection, or moving by that much per sample
+		bool nearLower, nearUpper, moving;
+
+		if (this->filter.isCircular()) {
+			// every edge is shared (if there's more than one position) and the
+			// bounds can cross the top of the range, so the distances are
+			// measured around the circle
+			const AnalogSelectorSpan Circumference = this->filter.getCircumference();
+			const bool Shared = (this->filter.getNumPositions() > 1);
+			const AnalogSelectorSpan margin = (Shared ? wrapDistance(lower, upper, Circumference) : Circumference) / 4;
+			const AnalogSelectorSpan Step = wrapDistance(this->lastReading, reading, Circumference);
+
+			nearLower = Shared && (wrapDistance(lower, reading, Circumference) < margin);
+			nearUpper = Shared && (wrapDistance(reading, upper, Circumference) < margin);
+			moving = ((Step < Circumference - Step) ? Step : Circumference - Step) >= margin;
+		}
+		else {
+			const int margin = (upper - lower) / 4;
+
+			nearLower = (selection > 0) && (reading - lower < margin);
+			nearUpper = (selection + 1 < this->filter.getNumPositions()) && (upper - reading < margin);
+			moving = abs(reading - this->lastReading) >= margin;
+		}
+
+		if (nearLower || nearUpper || moving) this->backoff = 0;
+		else if (this->backoff < this->maxBackoff) this->backoff++;
+	}
+
+	this->lastReading = reading;
+	return selection;
 #else
 	return 0;  // no Arduino support, can't read
 #endif
 }
 
+int AnalogSelector::getDetentOffset() const {
+	return this->filter.getDetentOffset(this->lastReading);
+}
+
+uint8_t AnalogSelector::getDetentLevel() const {
+	return this->filter.getDetentLevel(this->lastReading);
+}
+
+void AnalogSelector::configure(int rMin, int rMax, unsigned int numPos, float dz) {
+	this->filter.configure(rMin, rMax, numPos, dz);
+}
+
 void AnalogSelector::setRange(int rMin, int rMax) {
 	this->filter.setRange(rMin, rMax);
 }
@@ -249,3 +1149,136 @@ void AnalogSelector::setNumPositions(unsigned int numPos) {
 void AnalogSelector::setDeadzone(float dz) {
 	this->filter.setDeadzone(dz);
 }
+
+void AnalogSelector::setCircular(bool circular) {
+	this->filter.setCircular(circular);
+}
+
+void AnalogSelector::setSampleInterval(unsigned long interval) {
+	this->sampleInterval = interval;
+}
+
+void AnalogSelector::setAdaptiveSampling(uint8_t maxBackoff) {
+	if (maxBackoff > 15) maxBackoff = 15;  // keep the shift well inside the width of the interval
+	this->maxBackoff = maxBackoff;
+	if (this->backoff > maxBackoff) this->backoff = maxBackoff;
+}
+
+void AnalogSelector::setNoiseReduction(bool enabled) {
+#ifdef ANALOG_SELECTOR_ADC_SLEEP
+	if (enabled && !this->noiseReduction) {
+		analogRead(this->Pin);  // sets the ADC reference for the sleep conversions
+	}
+#endif
+	this->noiseReduction = enabled;
+}
+
+void AnalogSelector::setSmoothing(uint8_t shift) {
+	this->smoothing.setShift(shift);
+}
+
+void AnalogSelector::setClock(ClockFunction clock) {
+	Clock = clock;
+}
+
+
+AnalogSelectorFanout::AnalogSelectorFanout(unsigned int pin, AnalogSelectorFilter* const* filters, size_t count)
+	: Filters(filters), NumFilters(count), Pin(pin), smoothing(0)
+{}
+
+void AnalogSelectorFanout::begin() {
+#ifdef ARDUINO
+	pinMode(this->Pin, INPUT);
+#endif
+	this->update();  // set initial positions
+}
+
+int AnalogSelectorFanout::update() {
+#ifdef ARDUINO
+	const int reading = this->smoothing.process(analogRead(this->Pin));
+
+	for (size_t i = 0; i < this->NumFilters; i++) {
+		this->Filters[i]->getPosition(reading);
+	}
+
+	return reading;
+#else
+	return 0;  // no Arduino support, can't read
+#endif
+}
+
+void AnalogSelectorFanout::getPositions(unsigned int* output) {
+	this->update();
+
+	for (size_t i = 0; i < this->NumFilters; i++) {
+		output[i] = this->Filters[i]->getSelection();
+	}
+}
+
+unsigned int AnalogSelectorFanout::getPosition(size_t index) const {
+	return this->Filters[index]->getSelection();
+}
+
+size_t AnalogSelectorFanout::getNumFilters() const {
+	return this->NumFilters;
+}
+
+void AnalogSelectorFanout::setSmoothing(uint8_t shift) {
+	this->smoothing.setShift(shift);
+}
+
+
+PagedAnalogSelectorBase::PagedAnalogSelectorBase(AnalogSelector& selector, uint8_t* selections, uint8_t numPages)
+	: Selector(selector), Selections(selections), NumPages(numPages), page(0), pickup(Unknown)
+{}
+
+unsigned int PagedAnalogSelectorBase::getPosition() {
+	const unsigned int Position = this->Selector.getPosition();
+	uint8_t& selection = this->Selections[this->page];
+
+	// Pick up the knob once it reaches or passes the stored selection
+	// --------------------------------
+	if (this->pickup != PickedUp) {
+		const Pickup Side = (Position < selection) ? Below : (Position > selection) ? Above : PickedUp;
+
+		if (Side == PickedUp || (this->pickup != Unknown && Side != this->pickup)) {
+			this->pickup = PickedUp;
+		}
+		else {
+			this->pickup = Side;
+			return selection;  // not there yet, keep the stored value
+		}
+	}
+
+	selection = (Position > 0xFF) ? 0xFF : Position;
+	return selection;
+}
+
+void PagedAnalogSelectorBase::setPage(uint8_t page) {
+	if (page >= this->NumPages || page == this->page) return;
+	this->page = page;
+	this->pickup = Unknown;
+}
+
+uint8_t PagedAnalogSelectorBase::getPage() const {
+	return this->page;
+}
+
+uint8_t PagedAnalogSelectorBase::getNumPages() const {
+	return this->NumPages;
+}
+
+unsigned int PagedAnalogSelectorBase::getSelection(uint8_t page) const {
+	if (page >= this->NumPages) return 0;
+	return this->Selections[page];
+}
+
+void PagedAnalogSelectorBase::setSelection(uint8_t page, unsigned int selection) {
+	if (page >= this->NumPages) return;
+	this->Selections[page] = (selection > 0xFF) ? 0xFF : selection;
+	if (page == this->page) this->pickup = Unknown;
+}
+
+bool PagedAnalogSelectorBase::isPickedUp() const {
+	return this->pickup == PickedUp;
+}
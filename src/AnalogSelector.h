@@ -27,8 +27,128 @@
 #ifndef ANALOG_SELECTOR_H
 #define ANALOG_SELECTOR_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "AnalogSelectorTypes.h"
+
+#ifdef ANALOG_SELECTOR_TRACE
+#include "AnalogSelectorTrace.h"
+#endif
+
+
+#if defined(__GNUC__)
+#define ANALOG_SELECTOR_COLD __attribute__((noinline, cold))
+#else
+#define ANALOG_SELECTOR_COLD
+#endif
+
+
+#ifdef ANALOG_SELECTOR_STATS
+/**
+ * @brief Runtime statistics for an AnalogSelectorFilter instance
+ * 
+ * These counters are only compiled in if `ANALOG_SELECTOR_STATS` is defined.
+ * Because this changes the layout of the filter class, the flag must be set
+ * for every translation unit (i.e. as a compiler flag), not in a sketch.
+ */
+struct AnalogSelectorStats {
+	uint32_t samples;          ///< number of input samples run through the filter
+	uint32_t relativeScans;    ///< selection scans starting from the current selection
+	uint32_t absoluteScans;    ///< selection scans starting from the bottom of the range, after a config change
+	uint32_t edgeEvaluations;  ///< number of selection boundaries calculated
+	uint32_t transitions;      ///< number of times the selection has changed
+	uint32_t deadzoneSamples;  ///< number of input samples that landed in a deadzone
+	uint32_t cacheHits;        ///< configuration changes found in the layout cache
+	uint32_t cacheMisses;      ///< configuration changes that had to be calculated and added to the layout cache
+};
+#endif
+
+
+/**
+ * @brief Calculated layout for a filter configuration
+ */
+struct AnalogSelectorLayout {
+	AnalogSelectorValue rangeMin;     ///< the lower bound of the input range
+	AnalogSelectorValue rangeMax;     ///< the upper bound of the input range
+	unsigned int numPositions;        ///< the number of output positions
+	float deadzoneSize;               ///< the size of the deadzone segments, 0 - 1.0
+	bool circular;                    ///< whether the range wraps around
+	AnalogSelectorSpan selectorWidth; ///< the calculated width of each selector area, in user units
+	AnalogSelectorSpan deadzoneWidth; ///< the calculated width of each deadzone area, in user units
+};
+
+
+/**
+ * @brief Cache of calculated filter layouts
+ * 
+ * When a filter switches between a few configurations (e.g. one knob used
+ * for several pages of a UI), a cache lets it reuse the layout for a
+ * configuration it has seen recently instead of calculating it again. Once
+ * the cache is full the oldest entry is replaced.
+ * 
+ * This is the interface used by the filter. Create an AnalogSelectorCache
+ * for the storage.
+ */
+class AnalogSelectorCacheBase {
+public:
+	/**
+	 * Looks up the widths for a configuration
+	 * 
+	 * @param layout The layout to complete. The range, number of positions,
+	 *               and deadzone size are used as the key. If found, the
+	 *               widths are filled in from the cache.
+	 * @returns      'true' if the configuration was found, 'false' otherwise
+	*/
+	bool find(AnalogSelectorLayout& layout);
+
+	/**
+	 * Adds a calculated layout to the cache
+	 * 
+	 * @param layout The layout to add, with its widths calculated
+	*/
+	void store(const AnalogSelectorLayout& layout);
+
+	/**
+	 * Removes all entries from the cache
+	*/
+	void clear();
+
+protected:
+	/**
+	 * Class constructor
+	 * 
+	 * @param entries  Storage for the cache entries
+	 * @param capacity Number of entries in the storage
+	*/
+	AnalogSelectorCacheBase(AnalogSelectorLayout* entries, uint8_t capacity);
+
+private:
+	AnalogSelectorLayout* const Entries;  ///< the cache entries, owned by the derived class
+	const uint8_t Size;                   ///< the maximum number of entries
+	uint8_t count;                        ///< the number of valid entries
+	uint8_t next;                         ///< the index of the next entry to replace
+};
+
+
+/**
+ * @brief Cache of calculated filter layouts, with storage
+ * 
+ * @tparam Capacity Number of layouts to keep
+ * @see AnalogSelectorCacheBase
+ */
+template<uint8_t Capacity>
+class AnalogSelectorCache : public AnalogSelectorCacheBase {
+public:
+	/**
+	 * Class constructor
+	*/
+	AnalogSelectorCache() : AnalogSelectorCacheBase(this->storage, Capacity) {}
+
+private:
+	AnalogSelectorLayout storage[Capacity];  ///< the cache entries
+};
+
 
 /**
  * @brief Filter class for converting a position to a selector
@@ -73,30 +193,116 @@ public:
 	 * @param numPos Number of selector positions for the output
 	 * @param dz     Percentage of the range to act as a deadzone (0 - 1.0)
 	*/
-	AnalogSelectorFilter(int rMin, int rMax, unsigned int numPos, float dz);
+	AnalogSelectorFilter(AnalogSelectorValue rMin, AnalogSelectorValue rMax, unsigned int numPos, float dz);
 
 	/**
 	 * Runs the filter to obtain the current position of the selector
 	 * 
+	 * This is inlined so that the common case, where the input is still
+	 * within the bounds of the current selection, is only a range check.
+	 * Everything else is handled by AnalogSelectorFilter::updatePosition(AnalogSelectorValue).
+	 * 
 	 * @param pos Input position
 	 * @returns   The current position, indexed from 0
 	*/
-	unsigned int getPosition(int pos);
+	inline unsigned int getPosition(AnalogSelectorValue pos);
+
+	/**
+	 * Runs the filter over a block of input samples
+	 * 
+	 * This is equivalent to calling AnalogSelectorFilter::getPosition(AnalogSelectorValue)
+	 * once for each sample in order, and leaves the filter in the same state.
+	 * Each filter instance keeps its own state, so separate channels can be
+	 * processed by separate instances independently.
+	 * 
+	 * @param input  Input positions, in the user range
+	 * @param count  Number of samples to process
+	 * @param output Buffer for the resulting positions, at least 'count' long
+	*/
+	void getPositions(const AnalogSelectorValue* input, size_t count, unsigned int* output);
+
+	/**
+	 * Runs the filter over a block of interleaved 16-bit samples
+	 * 
+	 * Samples are read in place from a buffer with one or more channels
+	 * interleaved, such as a raw capture. To process a single channel, point
+	 * 'input' at that channel's first sample and set 'stride' to the number of
+	 * channels in the buffer.
+	 * 
+	 * @param input  First input sample for this channel, in the user range
+	 * @param count  Number of samples to process
+	 * @param stride Distance between consecutive samples, in samples
+	 * @param output Buffer for the resulting positions, at least 'count' long
+	*/
+	void getPositions(const int16_t* input, size_t count, size_t stride, unsigned int* output);
+
+	/**
+	 * Classifies an input against the layout, without hysteresis
+	 * 
+	 * The result doesn't depend on or change the current selection. Inputs
+	 * inside position 'i' give (2 * i). Inputs in the deadzone between
+	 * positions 'i' and 'i + 1', where the position from getPosition() would
+	 * depend on the previous selection, give (2 * i + 1). In circular mode
+	 * the deadzone between the last and first positions gives
+	 * (2 * numPositions - 1).
+	 * 
+	 * This uses the layout from the last call to configure() or
+	 * getPosition(). Changes made with the setters are not seen until then.
+	 * 
+	 * @param pos Input position, in the user range
+	 * @returns   The position band or deadzone the input falls in
+	*/
+	unsigned int classify(AnalogSelectorValue pos) const;
+
+	/**
+	 * Classifies a block of inputs against the layout, without hysteresis
+	 * 
+	 * Each sample is classified on its own, so this can run in parallel
+	 * (using OpenMP, if enabled).
+	 * 
+	 * @param input  Input positions, in the user range
+	 * @param count  Number of samples to process
+	 * @param output Buffer for the results, at least 'count' long
+	 * @see AnalogSelectorFilter::classify(AnalogSelectorValue) const
+	*/
+	void classify(const int16_t* input, size_t count, uint16_t* output) const;
+
+	/**
+	 * Sets the range, number of positions, and deadzone size at once
+	 * 
+	 * This is equivalent to calling AnalogSelectorFilter::setRange(AnalogSelectorValue, AnalogSelectorValue),
+	 * AnalogSelectorFilter::setNumPositions(unsigned int), and
+	 * AnalogSelectorFilter::setDeadzone(float), except that the widths are
+	 * recalculated once, immediately, and the current selection is carried
+	 * over to the new configuration. The new selection is the position that
+	 * contains the center of the previous one, so the next call to
+	 * AnalogSelectorFilter::getPosition(AnalogSelectorValue) can work from it rather than
+	 * starting over from the bottom of the range.
+	 * 
+	 * @param rMin   Minimum input range
+	 * @param rMax   Maximum input range
+	 * @param numPos Number of selector positions for the output
+	 * @param dz     Percentage of the range to act as a deadzone (0 - 1.0)
+	*/
+	void configure(AnalogSelectorValue rMin, AnalogSelectorValue rMax, unsigned int numPos, float dz);
 
 	/**
 	 * Sets the input range for the filter
 	 * 
-	 * Any input values for AnalogSelectorFilter::getPosition(int) outside of
+	 * Any input values for AnalogSelectorFilter::getPosition(AnalogSelectorValue) outside of
 	 * this range will be clipped to these values
 	 * 
 	 * @param rMin Minimum input range
 	 * @param rMax Maximum input range
 	*/
-	void setRange(int rMin, int rMax);
+	void setRange(AnalogSelectorValue rMin, AnalogSelectorValue rMax);
 
 	/**
 	 * Sets the number of output positions for the filter
 	 * 
+	 * Each position needs at least one step of the input range, so with more
+	 * positions than that the highest ones can't be selected.
+	 * 
 	 * @param numPos Number of output positions to set
 	*/
 	void setNumPositions(unsigned int numPos);
@@ -111,9 +317,171 @@ public:
 	*/
 	void setDeadzone(float dz);
 
+	/**
+	 * Sets whether the input range wraps around
+	 * 
+	 * This is for continuous rotation inputs like endless pots and magnetic
+	 * angle sensors, where the input goes from the top of the range straight
+	 * to the bottom. In circular mode the value after the maximum is the
+	 * minimum again, so the last and first positions are neighbors with a
+	 * deadzone between them. When the input jumps, the selection is found by
+	 * the shorter way around from the current one. Inputs outside of the
+	 * range are wrapped into it.
+	 * 
+	 * The edges of the selection containing the wrap point are split across
+	 * it, so the lower edge is above the upper edge.
+	 * 
+	 * @param circular 'true' to wrap the range, 'false' for a linear range
+	*/
+	void setCircular(bool circular);
+
+	/**
+	 * Gets the current selection without running the filter
+	 * 
+	 * @returns The last position calculated by the filter, indexed from 0
+	*/
+	unsigned int getSelection() const;
+
+	/**
+	 * Gets the lower bound of the input range
+	 * 
+	 * @returns The minimum input range, as set
+	*/
+	AnalogSelectorValue getRangeMin() const;
+
+	/**
+	 * Gets the upper bound of the input range
+	 * 
+	 * @returns The maximum input range, as set
+	*/
+	AnalogSelectorValue getRangeMax() const;
+
+	/**
+	 * Gets the number of output positions for the filter
+	 * 
+	 * @returns The number of output positions, as set
+	*/
+	unsigned int getNumPositions() const;
+
+	/**
+	 * Gets the size of the filter deadzones
+	 * 
+	 * @returns The deadzone size as a percentage, 0 - 1.0
+	*/
+	float getDeadzone() const;
+
+	/**
+	 * Checks whether the input range wraps around
+	 * 
+	 * @returns 'true' if the range is circular, 'false' if it's linear
+	*/
+	bool isCircular() const;
+
+	/**
+	 * Gets the distance around the input range if it's circular
+	 * 
+	 * This includes the step from the top of the range back to the bottom,
+	 * unless the range is the entire type and that would wrap to 0.
+	 * 
+	 * @returns The number of steps around the range
+	*/
+	AnalogSelectorSpan getCircumference() const;
+
+	/**
+	 * Sets a cache for calculated layouts
+	 * 
+	 * A cache can be shared between filters.
+	 * 
+	 * @param cache The cache to use, or 'nullptr' to always recalculate
+	*/
+	void setCache(AnalogSelectorCacheBase* cache);
+
+	/**
+	 * Gets the lower boundary of the current selection
+	 * 
+	 * If the input falls below this value the selection will decrease.
+	 * 
+	 * @returns The lower edge of the current selection, in the user range
+	*/
+	AnalogSelectorValue getLowerEdge() const;
+
+	/**
+	 * Gets the upper boundary of the current selection
+	 * 
+	 * If the input rises above this value the selection will increase.
+	 * 
+	 * @returns The upper edge of the current selection, in the user range
+	*/
+	AnalogSelectorValue getUpperEdge() const;
+
+	/**
+	 * Gets the distance from an input to the center of the current selection
+	 * 
+	 * The center (detent) of each selection is the middle of its area,
+	 * excluding the deadzones. This is updated whenever the selection
+	 * changes, so calling this only costs a subtraction. Use it with the
+	 * same input passed to AnalogSelectorFilter::getPosition(AnalogSelectorValue).
+	 * 
+	 * @param pos Input position, in the user range
+	 * @returns   The signed distance from the detent, in user units. Positive
+	 *            values are above the detent and negative values are below.
+	 *            Distances too large for the type are saturated.
+	*/
+	AnalogSelectorValue getDetentOffset(AnalogSelectorValue pos) const;
+
+	/**
+	 * Gets how close an input is to the center of the current selection
+	 * 
+	 * The result is scaled so that it can be written directly to an 8-bit PWM
+	 * output: 255 at the detent, falling linearly to 0 at the far side of the
+	 * deadzone on either side, where the selection changes.
+	 * 
+	 * @param pos Input position, in the user range
+	 * @returns   The closeness to the detent, 0 - 255
+	*/
+	uint8_t getDetentLevel(AnalogSelectorValue pos) const;
+
+#ifdef ANALOG_SELECTOR_STATS
+	/**
+	 * Gets the runtime statistics for the filter
+	 * 
+	 * @returns Reference to the statistics counters
+	*/
+	const AnalogSelectorStats& getStats() const;
+
+	/**
+	 * Resets all runtime statistics counters to 0
+	*/
+	void resetStats();
+#endif
+
+#ifdef ANALOG_SELECTOR_TRACE
+	/**
+	 * Sets the sink for trace records from this filter
+	 * 
+	 * A record is written when the configuration is recalculated and when the
+	 * selection changes. See AnalogSelectorTraceRecord for the record format.
+	 * 
+	 * @param sink The trace sink to write to, or 'nullptr' to disable tracing
+	*/
+	void setTraceSink(AnalogSelectorTraceSink* sink);
+#endif
+
 private:
 	enum Direction { Upper, Lower };  ///< Simple enum to handle direction selection
 
+	/**
+	 * Runs the filter for an input outside of the current bounds, or after
+	 * the configuration has changed
+	 * 
+	 * This is the slow path for AnalogSelectorFilter::getPosition(AnalogSelectorValue), and is
+	 * kept out of line so that the fast path stays small.
+	 * 
+	 * @param pos Input position
+	 * @returns   The current position, indexed from 0
+	*/
+	ANALOG_SELECTOR_COLD unsigned int updatePosition(AnalogSelectorValue pos);
+
 	/**
 	 * Calculates the boundary for changing positions
 	 * 
@@ -125,7 +493,31 @@ private:
 	 * @param dir Which boundary to calculate, Upper or Lower
 	 * @returns   The calculated boundary, in the user range
 	*/
-	int calculateEdge(unsigned int i, Direction dir) const;
+	AnalogSelectorValue calculateEdge(unsigned int i, Direction dir) const;
+
+	/**
+	 * Calculates the selection for an input approaching from below
+	 * 
+	 * Each position and the deadzone above it repeat every
+	 * (selectorWidth + deadzoneWidth) units, so the selection can be found by
+	 * division instead of a search. Inputs in a deadzone resolve to the
+	 * position below it.
+	 * 
+	 * @param pos Input position, in the user range
+	 * @returns   The lowest selection whose upper edge is at or above the input
+	*/
+	unsigned int calculateSelectionUp(AnalogSelectorValue pos) const;
+
+	/**
+	 * Calculates the selection for an input approaching from above
+	 * 
+	 * This is the counterpart to AnalogSelectorFilter::calculateSelectionUp(AnalogSelectorValue).
+	 * Inputs in a deadzone resolve to the position above it.
+	 * 
+	 * @param pos Input position, in the user range
+	 * @returns   The highest selection whose lower edge is at or below the input
+	*/
+	unsigned int calculateSelectionDown(AnalogSelectorValue pos) const;
 
 	/**
 	 * Recalculates the width of each selector and deadzone area
@@ -141,34 +533,418 @@ private:
 	*/
 	void recalculateWidths();
 
+	/**
+	 * Calculates the width of each selector and deadzone area from the
+	 * current configuration
+	 * 
+	 * This does the work for AnalogSelectorFilter::recalculateWidths() when
+	 * the layout is not in the cache.
+	*/
+	void calculateWidths();
+
 	/**
 	 * Calculates the position of the selector from the input
 	 * 
 	 * @param pos      Input position, in the user range
-	 * @param relative Whether to use relative calculations. If 'true', selection
-	 *                 calculation begins from the current selection and moves up
-	 *                 or down. If 'false', selection calculation begins from the
-	 *                 bottom and moves to the top. Relative calculations are more
-	 *                 efficient, but they require a known starting position.
+	 * @param relative Whether to use relative calculations. If 'true', the
+	 *                 selection only changes if the input is outside of the
+	 *                 current bounds, and any deadzone is resolved in the
+	 *                 direction of travel. If 'false', the selection is
+	 *                 calculated as if approached from the bottom of the range.
+	 *                 Relative calculations require a known starting position.
 	 * @returns        The position of the selector, indexed from 0
 	*/
-	unsigned int calculateSelection(int pos, bool relative);
+	unsigned int calculateSelection(AnalogSelectorValue pos, bool relative);
+
+	/**
+	 * Calculates the selection on a circular range
+	 * 
+	 * This is AnalogSelectorFilter::calculateSelection() for circular mode.
+	 * The layout is the same as the linear one, but with a deadzone between
+	 * the last and first positions. Inputs that leave the current bounds are
+	 * treated as having moved up or down, whichever is shorter around the
+	 * circle.
+	 * 
+	 * @param pos      Input position
+	 * @param relative Whether to calculate the position relative to the
+	 *                 previous selection, or absolute from the bottom
+	 * @returns        The position of the selector, indexed from 0
+	*/
+	unsigned int calculateCircularSelection(AnalogSelectorValue pos, bool relative);
+
+	/**
+	 * @brief The bound held by a selection on a circular range
+	 */
+	struct CircularBound {
+		AnalogSelectorSpan start;   ///< offset of the lower edge from the bottom of the range
+		AnalogSelectorSpan length;  ///< distance from the lower edge up to the upper edge, which may cross the top of the range
+	};
+
+	/**
+	 * Calculates the bound held by a selection on a circular range
+	 * 
+	 * This is the position's selector area and the deadzones on both sides
+	 * of it. The last position is also held over the deadzone up to the top
+	 * of the circle, and position 0 is held back over it.
+	 * 
+	 * @param i             Selection index, indexed from 0
+	 * @param circumference Distance around the range, from
+	 *                      AnalogSelectorFilter::getCircumference()
+	 * @returns             The start and length of the bound
+	*/
+	CircularBound calculateCircularBound(unsigned int i, AnalogSelectorSpan circumference) const;
+
+#if defined(ANALOG_SELECTOR_STATS) || defined(ANALOG_SELECTOR_TRACE)
+	/**
+	 * Records the result of a selection calculation in the statistics and
+	 * the trace
+	 * 
+	 * This is shared by the linear and circular selection paths, and is
+	 * called after the current selection and its bounds are updated.
+	 * 
+	 * @param pos      Input position, as passed to the filter
+	 * @param relative Whether the selection was calculated relative to the
+	 *                 previous selection
+	 * @param previous The selection before this input
+	 * @param into     Distance of the input up from the lower edge of the
+	 *                 current bound
+	 * @param length   Distance from the lower edge of the current bound up to
+	 *                 the upper edge
+	*/
+	void recordSelection(AnalogSelectorValue pos, bool relative, unsigned int previous, AnalogSelectorSpan into, AnalogSelectorSpan length);
+#endif
 
 	// Config data
-	bool configChanged;             ///< flag that's set if the config is changed, so we can recalculate widths
-	int rangeMin;                   ///< the lower bound of the input range
-	int rangeMax;                   ///< the upper bound of the input range
-	unsigned int numPositions;      ///< the number of output positions for the selector
-	float deadzoneSize;             ///< the size of the deadzone segments, 0 - 1.0 as a percentage of the total range
+	bool configChanged;               ///< flag that's set if the config is changed, so we can recalculate widths
+	AnalogSelectorValue rangeMin;     ///< the lower bound of the input range
+	AnalogSelectorValue rangeMax;     ///< the upper bound of the input range
+	unsigned int numPositions;        ///< the number of output positions for the selector
+	float deadzoneSize;               ///< the size of the deadzone segments, 0 - 1.0 as a percentage of the total range
+	bool circular;                    ///< flag that's set if the range wraps around
 
 	// Calculated Config Widths
-	unsigned int selectorWidth;     ///< the width of each selector area, in user units
-	unsigned int deadzoneWidth;     ///< the width of each deadzone area, in user units
+	AnalogSelectorSpan selectorWidth; ///< the width of each selector area, in user units
+	AnalogSelectorSpan deadzoneWidth; ///< the width of each deadzone area, in user units
+	uint32_t positionsReciprocal;     ///< fixed point reciprocal of the number of positions, for division
+	uint32_t deadzonesReciprocal;     ///< fixed point reciprocal of the number of deadzones, for division
+	bool reciprocalsValid;            ///< whether the reciprocals match the number of positions
+	AnalogSelectorCacheBase* cache;   ///< cache of calculated layouts, if any
 
 	// Current Status data
-	int edgeLow;                    ///< the lower edge of the current selection bound, in user units
-	unsigned int currentSelection;  ///< the current selection, buffered for efficiency
-	int edgeHigh;                   ///< the upper edge of the current selection bound, in user units
+	AnalogSelectorValue edgeLow;      ///< the lower edge of the current selection bound, in user units
+	unsigned int currentSelection;    ///< the current selection, buffered for efficiency
+	AnalogSelectorValue edgeHigh;     ///< the upper edge of the current selection bound, in user units
+	AnalogSelectorValue detentCenter; ///< the center of the current selection, excluding deadzones, in user units
+	mutable uint16_t detentScale;     ///< scale from detent offset to level, 8.8 fixed point. Calculated on first use, 0 if not yet calculated.
+
+#ifdef ANALOG_SELECTOR_STATS
+	mutable AnalogSelectorStats stats;  ///< runtime statistics counters
+#endif
+
+#ifdef ANALOG_SELECTOR_TRACE
+	AnalogSelectorTraceSink* traceSink;  ///< the output for trace records, if any
+#endif
+};
+
+
+unsigned int AnalogSelectorFilter::getPosition(AnalogSelectorValue pos) {
+#ifndef ANALOG_SELECTOR_STATS  // the statistics need to see every sample
+	if (!this->configChanged && pos >= this->edgeLow && pos <= this->edgeHigh) {
+		return this->currentSelection;
+	}
+#endif
+	return updatePosition(pos);
+}
+
+
+/**
+ * @brief Filter for a selector with positions on either side of a center
+ * 
+ * This is for trim knobs and joystick-like inputs, where the output is signed
+ * and the center has a wider band than the other positions, e.g. -3 ... 0 ...
+ * +3. Each side is an AnalogSelectorFilter with its own number of positions,
+ * so the two sides can have different widths.
+ * 
+ * Inputs within half of the center width of the center select 0. Once an
+ * input has left the center it has to come back past the edge of the center
+ * band by the deadzone size (as a fraction of the half band) to return to 0.
+ */
+class BipolarAnalogSelectorFilter {
+public:
+	/**
+	 * Class constructor
+	 * 
+	 * @param rMin        Minimum input range
+	 * @param center      Center of the input range
+	 * @param rMax        Maximum input range
+	 * @param stepsDown   Number of positions below the center
+	 * @param stepsUp     Number of positions above the center
+	 * @param centerWidth Width of the center band, in user units
+	 * @param dz          Percentage of the range to act as a deadzone (0 - 1.0)
+	*/
+	BipolarAnalogSelectorFilter(AnalogSelectorValue rMin, AnalogSelectorValue center, AnalogSelectorValue rMax,
+		unsigned int stepsDown, unsigned int stepsUp, AnalogSelectorSpan centerWidth, float dz);
+
+	/**
+	 * Runs the filter to obtain the current position of the selector
+	 * 
+	 * When the input hasn't changed sides this is the center band check or
+	 * the side filter's fast path.
+	 * 
+	 * @param pos Input position
+	 * @returns   The current position, negative below the center, 0 at the
+	 *            center, and positive above it
+	*/
+	inline int getPosition(AnalogSelectorValue pos);
+
+	/**
+	 * Sets the whole layout at once
+	 * 
+	 * @see BipolarAnalogSelectorFilter::BipolarAnalogSelectorFilter()
+	*/
+	void configure(AnalogSelectorValue rMin, AnalogSelectorValue center, AnalogSelectorValue rMax,
+		unsigned int stepsDown, unsigned int stepsUp, AnalogSelectorSpan centerWidth, float dz);
+
+	/**
+	 * Gets the current selection of the filter, without running the filter
+	 * 
+	 * @returns The current selection, negative below the center
+	*/
+	int getSelection() const;
+
+	/**
+	 * Gets the center of the input range
+	 * 
+	 * @returns The center, as set
+	*/
+	AnalogSelectorValue getCenter() const;
+
+private:
+	/**
+	 * Runs the filter for an input that may have changed sides
+	 * 
+	 * @param pos Input position
+	 * @returns   The current position
+	*/
+	ANALOG_SELECTOR_COLD int updatePosition(AnalogSelectorValue pos);
+
+	AnalogSelectorFilter lower;   ///< the positions below the center band
+	AnalogSelectorFilter upper;   ///< the positions above the center band
+	AnalogSelectorValue center;   ///< the center of the input range
+	AnalogSelectorValue bandLow;  ///< the lowest input in the center band
+	AnalogSelectorValue bandHigh; ///< the highest input in the center band
+	AnalogSelectorValue exitLow;  ///< the input above which the lower side returns to the center
+	AnalogSelectorValue exitHigh; ///< the input below which the upper side returns to the center
+	unsigned int stepsDown;       ///< the number of positions below the center
+	unsigned int stepsUp;         ///< the number of positions above the center
+	int selection;                ///< the current selection, negative below the center
+};
+
+
+int BipolarAnalogSelectorFilter::getPosition(AnalogSelectorValue pos) {
+	if (this->selection > 0) {
+		if (pos >= this->exitHigh) return this->selection = (int) this->upper.getPosition(pos) + 1;
+	}
+	else if (this->selection < 0) {
+		if (pos <= this->exitLow) return this->selection = (int) this->lower.getPosition(pos) - (int) this->stepsDown;
+	}
+	else if (pos >= this->bandLow && pos <= this->bandHigh) {
+		return 0;
+	}
+	return updatePosition(pos);
+}
+
+
+/**
+ * @brief Filter for a two-axis input split into direction sectors
+ * 
+ * This reads a joystick as a direction selector. Inputs within the dead
+ * radius of the center select 0. Outside of it, the plane is split into
+ * equal sectors numbered from 1, counter-clockwise, with sector 1 centered
+ * on the positive X axis. Eight sectors and the center give the 3x3 grid
+ * with round diagonals.
+ * 
+ * Both the radius and the angle have hysteresis. Once outside, the input
+ * returns to the center below (1 - dz / 4) of the radius, so 3/4 of it with
+ * the full deadzone. Each sector boundary is held past by (dz / 4) of a
+ * sector. The boundaries are stored as Q14 unit vectors when the filter is
+ * configured, and inputs are compared against them with cross products, so
+ * there is no trigonometry while running.
+ * 
+ * Create an AnalogSelectorFilter2D for the storage.
+ */
+class AnalogSelectorFilter2DBase {
+public:
+	/**
+	 * Runs the filter to obtain the current sector of the input
+	 * 
+	 * @param x Input position on the X axis
+	 * @param y Input position on the Y axis
+	 * @returns The current sector, 1 - numSectors, or 0 for the center
+	*/
+	unsigned int getPosition(AnalogSelectorValue x, AnalogSelectorValue y);
+
+	/**
+	 * Runs the filter over a block of input samples
+	 * 
+	 * @param x      Input positions on the X axis
+	 * @param y      Input positions on the Y axis
+	 * @param count  Number of samples to process
+	 * @param output Buffer for the resulting sectors, at least 'count' long
+	*/
+	void getPositions(const AnalogSelectorValue* x, const AnalogSelectorValue* y, size_t count, unsigned int* output);
+
+	/**
+	 * Sets the center, the dead radius, and the deadzone size
+	 * 
+	 * @param cx     Center of the X axis
+	 * @param cy     Center of the Y axis
+	 * @param radius Radius around the center that selects 0, in user units
+	 * @param dz     Size of the deadzones between sectors and around the
+	 *               center radius (0 - 1.0)
+	*/
+	void configure(AnalogSelectorValue cx, AnalogSelectorValue cy, AnalogSelectorSpan radius, float dz);
+
+	/**
+	 * Gets the current selection of the filter, without running the filter
+	 * 
+	 * @returns The current sector, 1 - numSectors, or 0 for the center
+	*/
+	unsigned int getSelection() const;
+
+	/**
+	 * Gets the number of sectors around the center
+	 * 
+	 * @returns The number of sectors
+	*/
+	uint8_t getNumSectors() const;
+
+protected:
+	/**
+	 * Class constructor
+	 * 
+	 * @param boundaries Storage for the sector boundaries, two per sector
+	 * @param numSectors Number of sectors
+	 * @param cx         Center of the X axis
+	 * @param cy         Center of the Y axis
+	 * @param radius     Radius around the center that selects 0
+	 * @param dz         Size of the deadzones (0 - 1.0)
+	*/
+	AnalogSelectorFilter2DBase(int16_t* boundaries, uint8_t numSectors,
+		AnalogSelectorValue cx, AnalogSelectorValue cy, AnalogSelectorSpan radius, float dz);
+
+private:
+	/**
+	 * Finds the sector an input is in, without hysteresis
+	 * 
+	 * @param dx Input distance from the center on the X axis, reduced to 16 bits
+	 * @param dy Input distance from the center on the Y axis, reduced to 16 bits
+	 * @returns  The sector, 1 - numSectors
+	*/
+	unsigned int calculateSector(int32_t dx, int32_t dy) const;
+
+	/**
+	 * Sets the selection and rotates its boundaries out by the deadzone
+	 * 
+	 * @param sector The new selection, 1 - numSectors, or 0 for the center
+	*/
+	void setSelection(unsigned int sector);
+
+	int16_t* const Boundaries;      ///< the lower boundary of each sector as a Q14 unit vector, x then y, owned by the derived class
+	const uint8_t NumSectors;       ///< the number of sectors around the center
+	AnalogSelectorValue centerX;    ///< the center of the X axis
+	AnalogSelectorValue centerY;    ///< the center of the Y axis
+	uint32_t radiusEnter;           ///< squared radius above which the input leaves the center
+	uint32_t radiusExit;            ///< squared radius below which the input returns to the center
+	AnalogSelectorSpan radiusLimit; ///< distance on either axis past which the input is outside the center
+	int16_t deadzoneCos;            ///< cosine of the angular deadzone, Q14
+	int16_t deadzoneSin;            ///< sine of the angular deadzone, Q14
+	int16_t holdLow[2];             ///< lower boundary of the current sector, rotated out by the deadzone
+	int16_t holdHigh[2];            ///< upper boundary of the current sector, rotated out by the deadzone
+	uint8_t selection;              ///< the current sector, or 0 for the center
+};
+
+
+/**
+ * @brief Filter for a two-axis input split into direction sectors, with storage
+ * 
+ * @tparam Sectors Number of sectors around the center, 4 - 64
+ * @see AnalogSelectorFilter2DBase
+ */
+template<uint8_t Sectors>
+class AnalogSelectorFilter2D : public AnalogSelectorFilter2DBase {
+public:
+	static_assert(Sectors >= 4 && Sectors <= 64, "Sectors must be between 4 and 64");
+
+	/** @copydoc AnalogSelectorFilter2DBase::configure() */
+	AnalogSelectorFilter2D(AnalogSelectorValue cx, AnalogSelectorValue cy, AnalogSelectorSpan radius, float dz)
+		: AnalogSelectorFilter2DBase(this->storage, Sectors, cx, cy, radius, dz) {}
+
+private:
+	int16_t storage[Sectors * 2];  ///< the sector boundaries
+};
+
+
+/**
+ * @brief Exponential moving average filter using integer math
+ * 
+ * This smooths the input before it reaches the selector, so that smaller
+ * deadzones can be used with noisy inputs. Each new sample is weighted by
+ * 1 / 2^shift, so larger shifts give more smoothing and slower response.
+ * 
+ * The first sample after construction or a reset is used as the starting
+ * average, so the output does not ramp up from 0.
+ * 
+ * This can be used as a stage in an AnalogSelectorChain.
+ */
+class AnalogSelectorEma {
+public:
+	/**
+	 * Class constructor
+	 * 
+	 * @param shift Smoothing amount, as a power of 2 (0 - 15). Defaults to 2,
+	 *              weighting each sample by 1/4.
+	*/
+	AnalogSelectorEma(uint8_t shift = 2);
+
+	/**
+	 * Adds a sample to the average
+	 * 
+	 * @param value The input sample
+	 * @returns     The current average, rounded to the nearest integer
+	*/
+	AnalogSelectorValue process(AnalogSelectorValue value);
+
+	/**
+	 * Sets the smoothing amount and resets the average
+	 * 
+	 * @param shift Smoothing amount, as a power of 2 (0 - 15). Use 0 to pass
+	 *              samples through unchanged.
+	*/
+	void setShift(uint8_t shift);
+
+	/**
+	 * Gets the smoothing amount
+	 * 
+	 * @returns The smoothing amount, as a power of 2
+	*/
+	uint8_t getShift() const;
+
+	/**
+	 * Resets the average, so that the next sample becomes the starting value
+	*/
+	void reset();
+
+private:
+#ifdef ANALOG_SELECTOR_WIDE
+	typedef int64_t Accumulator;  ///< wide enough for a 32-bit input scaled by 2^15
+#else
+	typedef long Accumulator;     ///< wide enough for a 16-bit input scaled by 2^15
+#endif
+
+	Accumulator accumulator;  ///< the current average, scaled up by 2^shift
+	uint8_t shift;            ///< the smoothing amount, as a power of 2
+	bool seeded;              ///< whether the accumulator has been set from a sample
 };
 
 
@@ -199,7 +975,10 @@ public:
 	*/
 	unsigned int getPosition();
 
-	/** @copydoc AnalogSelectorFilter::setRange(int, int) */
+	/** @copydoc AnalogSelectorFilter::configure(AnalogSelectorValue, AnalogSelectorValue, unsigned int, float) */
+	void configure(int rMin, int rMax, unsigned int numPos, float dz);
+
+	/** @copydoc AnalogSelectorFilter::setRange(AnalogSelectorValue, AnalogSelectorValue) */
 	void setRange(int rMin, int rMax);
 
 	/** @copydoc AnalogSelectorFilter::setNumPositions(unsigned int) */
@@ -208,9 +987,315 @@ public:
 	/** @copydoc AnalogSelectorFilter::setDeadzone(float) */
 	void setDeadzone(float dz);
 
+	/** @copydoc AnalogSelectorFilter::setCircular(bool) */
+	void setCircular(bool circular);
+
+	/**
+	 * Sets the minimum time between input samples
+	 * 
+	 * If set, AnalogSelector::getPosition() will only read the input once
+	 * the interval has elapsed since the last reading. Calls made before then
+	 * return the last selection without sampling.
+	 * 
+	 * @param interval Minimum time between samples, in the units of the
+	 *                 clock function (microseconds by default). Use 0 to
+	 *                 sample on every call.
+	*/
+	void setSampleInterval(unsigned long interval);
+
+	/**
+	 * Enables adaptive sampling based on input activity
+	 * 
+	 * While the input is steady and well inside the bounds of the current
+	 * selection, the sample interval is doubled after each reading, up to
+	 * (interval << maxBackoff), saturating at the largest interval the clock
+	 * can measure. As soon as the input approaches the edge of
+	 * the selection or moves quickly, it returns to the base interval.
+	 * 
+	 * This requires a sample interval to be set with
+	 * AnalogSelector::setSampleInterval(unsigned long).
+	 * 
+	 * @param maxBackoff Maximum number of times to double the sample
+	 *                   interval, up to 15. Use 0 to disable adaptive
+	 *                   sampling.
+	*/
+	void setAdaptiveSampling(uint8_t maxBackoff);
+
+	/**
+	 * Enables sampling in ADC noise reduction sleep mode
+	 * 
+	 * On supported AVR boards the CPU sleeps while the ADC converts, which
+	 * reduces both power use and digital noise in the reading. The CPU wakes
+	 * when the conversion completes. While asleep the CPU clock is stopped,
+	 * including the timer used by `millis()` and `micros()`, so those will lag
+	 * slightly for each sample taken.
+	 * 
+	 * The conversion reuses the ADC reference from the last `analogRead()`.
+	 * Enabling this mode performs one normal reading to set the reference.
+	 * The interrupt state is restored after each sample, so this is safe to
+	 * use with interrupts disabled. On other platforms this has no effect and
+	 * `analogRead()` is used.
+	 * 
+	 * @param enabled Whether to sample in noise reduction mode
+	*/
+	void setNoiseReduction(bool enabled);
+
+	/**
+	 * Sets the amount of smoothing applied to readings before the filter
+	 * 
+	 * Readings are smoothed with an exponential moving average. See
+	 * AnalogSelectorEma for details.
+	 * 
+	 * @param shift Smoothing amount, as a power of 2 (0 - 15). Use 0 to
+	 *              disable smoothing (default).
+	*/
+	void setSmoothing(uint8_t shift);
+
+	/**
+	 * Gets the distance from the last reading to the center of the selection
+	 * 
+	 * @returns The signed distance from the detent, in user units
+	 * @see AnalogSelectorFilter::getDetentOffset(AnalogSelectorValue)
+	*/
+	int getDetentOffset() const;
+
+	/**
+	 * Gets how close the last reading is to the center of the selection
+	 * 
+	 * @returns The closeness to the detent, 0 - 255
+	 * @see AnalogSelectorFilter::getDetentLevel(AnalogSelectorValue)
+	*/
+	uint8_t getDetentLevel() const;
+
+	/// Function type for the sampling clock, returning the current time
+	typedef unsigned long (*ClockFunction)();
+
+	/**
+	 * Sets the clock used to time samples for all selectors
+	 * 
+	 * On Arduino this defaults to `micros()`. On other platforms there is
+	 * no default and sample intervals have no effect until a clock is set.
+	 * 
+	 * @param clock Function returning the current time, or 'nullptr' to
+	 *              disable sample intervals
+	*/
+	static void setClock(ClockFunction clock);
+
 private:
+	/**
+	 * Reads the input and runs the filter, ignoring the sample interval
+	 * 
+	 * @returns The current position, indexed from 0
+	*/
+	unsigned int sample();
+
 	AnalogSelectorFilter filter;  ///< AnalogSelectorFilter instance, via composition for a cleaner interface
 	const unsigned int Pin;       ///< The analog pin, in Arduino numbering, used by this class
+
+	unsigned long sampleInterval; ///< the minimum time between samples, in clock units
+	unsigned long lastSample;     ///< the clock time when the input was last sampled
+	int lastReading;              ///< the input reading from the last sample
+	uint8_t backoff;              ///< the current adaptive sampling step, as a left shift of the interval
+	uint8_t maxBackoff;           ///< the maximum adaptive sampling step
+	bool noiseReduction;          ///< whether to sample in ADC noise reduction mode
+	AnalogSelectorEma smoothing;  ///< moving average applied to readings before the filter
+
+	static ClockFunction Clock;   ///< the clock function for sample timing, shared by all selectors
+};
+
+
+/**
+ * @brief Analog input shared by several selector filters
+ * 
+ * This reads the analog pin once per update and runs the reading through
+ * every attached filter, so the same input can be interpreted in several
+ * ways (e.g. a coarse 4 position mode and a fine 32 position value) without
+ * sampling the pin more than once.
+ * 
+ * The filters are owned by the caller and passed in as an array of pointers,
+ * which must remain valid for the lifetime of this object.
+ */
+class AnalogSelectorFanout {
+public:
+	/**
+	 * Class constructor
+	 * 
+	 * @param pin     Analog pin to read from
+	 * @param filters Array of filters to update from the pin
+	 * @param count   Number of filters in the array
+	*/
+	AnalogSelectorFanout(unsigned int pin, AnalogSelectorFilter* const* filters, size_t count);
+
+	/**
+	 * Initializes the pin by setting it to 'input'
+	*/
+	void begin();
+
+	/**
+	 * Reads the pin and runs the reading through every filter
+	 * 
+	 * @returns The reading from the pin, after any smoothing
+	*/
+	int update();
+
+	/**
+	 * Reads the pin and gets the position of every filter
+	 * 
+	 * @param output Buffer for the positions, at least as long as the number
+	 *               of filters, in the same order as the filters
+	*/
+	void getPositions(unsigned int* output);
+
+	/**
+	 * Gets the position of one filter from the last update
+	 * 
+	 * @param index Index of the filter in the array
+	 * @returns     The position of that filter, indexed from 0
+	*/
+	unsigned int getPosition(size_t index) const;
+
+	/**
+	 * Gets the number of filters attached
+	 * 
+	 * @returns The number of filters
+	*/
+	size_t getNumFilters() const;
+
+	/** @copydoc AnalogSelector::setSmoothing(uint8_t) */
+	void setSmoothing(uint8_t shift);
+
+private:
+	AnalogSelectorFilter* const* Filters;  ///< the filters updated from the pin, owned by the caller
+	const size_t NumFilters;               ///< the number of filters in the array
+	const unsigned int Pin;                ///< The analog pin, in Arduino numbering, used by this class
+	AnalogSelectorEma smoothing;           ///< moving average applied to readings before the filters
 };
 
+
+/**
+ * @brief Several virtual selectors sharing one physical selector
+ * 
+ * Each page keeps its own selection, and only the active page follows the
+ * knob. After a page switch the page "picks up" the knob again
+ * (soft-takeover): its selection does not change until the knob reaches or
+ * passes through the stored selection, so switching pages never makes a
+ * value jump.
+ * 
+ * Each page's state is a single byte, so selections are limited to 0 - 255.
+ * Create a PagedAnalogSelector for the storage.
+ */
+class PagedAnalogSelectorBase {
+public:
+	/**
+	 * Runs the selector and updates the active page
+	 * 
+	 * @returns The selection of the active page, indexed from 0
+	*/
+	unsigned int getPosition();
+
+	/**
+	 * Switches the active page
+	 * 
+	 * The page will not follow the knob until it has been picked up.
+	 * 
+	 * @param page The page to switch to. Out of range pages are ignored.
+	*/
+	void setPage(uint8_t page);
+
+	/**
+	 * Gets the active page
+	 * 
+	 * @returns The active page, indexed from 0
+	*/
+	uint8_t getPage() const;
+
+	/**
+	 * Gets the number of pages
+	 * 
+	 * @returns The number of pages
+	*/
+	uint8_t getNumPages() const;
+
+	/**
+	 * Gets the stored selection of a page, without running the selector
+	 * 
+	 * @param page The page to get the selection of
+	 * @returns    The selection of that page, indexed from 0
+	*/
+	unsigned int getSelection(uint8_t page) const;
+
+	/**
+	 * Sets the stored selection of a page, e.g. when restoring saved settings
+	 * 
+	 * If this is the active page it has to be picked up again.
+	 * 
+	 * @param page      The page to set the selection of
+	 * @param selection The new selection, indexed from 0
+	*/
+	void setSelection(uint8_t page, unsigned int selection);
+
+	/**
+	 * Checks whether the active page has picked up the knob
+	 * 
+	 * @returns 'true' if the active page is following the knob, 'false' if it
+	 *          is waiting for the knob to reach its selection
+	*/
+	bool isPickedUp() const;
+
+protected:
+	/**
+	 * Class constructor
+	 * 
+	 * @param selector   The physical selector shared by the pages
+	 * @param selections Storage for the page selections
+	 * @param numPages   Number of pages in the storage
+	*/
+	PagedAnalogSelectorBase(AnalogSelector& selector, uint8_t* selections, uint8_t numPages);
+
+private:
+	/** State of the active page, relative to the knob */
+	enum Pickup : uint8_t {
+		Unknown,   ///< page was just switched, knob not read yet
+		Below,     ///< knob is below the page selection
+		Above,     ///< knob is above the page selection
+		PickedUp,  ///< page is following the knob
+	};
+
+	AnalogSelector& Selector;   ///< the physical selector, owned by the caller
+	uint8_t* const Selections;  ///< the selection of each page, owned by the derived class
+	const uint8_t NumPages;     ///< the number of pages
+	uint8_t page;               ///< the active page
+	Pickup pickup;              ///< the pickup state of the active page
+};
+
+
+/**
+ * @brief Several virtual selectors sharing one physical selector, with storage
+ * 
+ * @tparam Pages Number of pages
+ * @see PagedAnalogSelectorBase
+ */
+template<uint8_t Pages>
+class PagedAnalogSelector : public PagedAnalogSelectorBase {
+public:
+	/**
+	 * Class constructor
+	 * 
+	 * @param selector The physical selector shared by the pages
+	*/
+	PagedAnalogSelector(AnalogSelector& selector)
+		: PagedAnalogSelectorBase(selector, this->storage, Pages), storage() {}
+
+private:
+	uint8_t storage[Pages];  ///< the selection of each page
+};
+
+
+#include "AnalogSelectorChain.h"
+#include "AnalogSelectorMedian.h"
+
+inline unsigned int AnalogSelectorStage<AnalogSelectorFilter>::run(AnalogSelectorFilter& filter, AnalogSelectorValue value) {
+	return filter.getPosition(value);
+}
+
 #endif
@@ -0,0 +1,186 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ANALOG_SELECTOR_CHAIN_H
+#define ANALOG_SELECTOR_CHAIN_H
+
+#include <stddef.h>
+
+#include "AnalogSelectorTypes.h"
+
+class AnalogSelectorFilter;
+
+
+/**
+ * @brief Describes how an AnalogSelectorChain runs one of its stages
+ * 
+ * By default a stage is any class with an
+ * `AnalogSelectorValue process(AnalogSelectorValue)` function that takes a
+ * sample and returns the filtered sample. The AnalogSelectorFilter
+ * specialization runs the selector instead, producing a position.
+ * 
+ * @tparam Stage The stage type
+ */
+template<typename Stage>
+struct AnalogSelectorStage {
+	typedef AnalogSelectorValue Output;  ///< the type of value produced by the stage
+
+	/**
+	 * Runs one sample through the stage
+	 * 
+	 * @param stage The stage instance
+	 * @param value The input sample
+	 * @returns     The output of the stage
+	*/
+	static inline Output run(Stage& stage, AnalogSelectorValue value) {
+		return stage.process(value);
+	}
+};
+
+template<>
+struct AnalogSelectorStage<AnalogSelectorFilter> {
+	typedef unsigned int Output;
+
+	static inline Output run(AnalogSelectorFilter& filter, AnalogSelectorValue value);
+};
+
+
+/**
+ * @brief Statically composed pipeline of filter stages
+ * 
+ * Each sample is passed through the stages in order, with the output of one
+ * stage as the input to the next. The stages are resolved at compile time, so
+ * there are no virtual calls and the compiler is free to inline the whole
+ * pipeline into the caller's loop. For example:
+ * 
+ * ```
+ * AnalogSelectorChain<AnalogSelectorMedian<3>, AnalogSelectorEma, AnalogSelectorFilter> chain(0, 1023, 5, 0.1);
+ * chain.getNext().getStage().setShift(3);
+ * unsigned int position = chain.process(analogRead(A0));
+ * ```
+ * 
+ * All stages but the last are default constructed. Any constructor arguments
+ * for the chain are passed to the last stage.
+ * 
+ * @tparam Stages The stage types, in the order they are run
+ */
+template<typename... Stages>
+class AnalogSelectorChain;
+
+template<typename Stage>
+class AnalogSelectorChain<Stage> {
+public:
+	typedef typename AnalogSelectorStage<Stage>::Output Output;  ///< the type of value produced by the chain
+
+	/**
+	 * Class constructor
+	 * 
+	 * @param args Arguments for the stage's constructor
+	*/
+	template<typename... Args>
+	AnalogSelectorChain(Args... args) : stage(args...) {}
+
+	/**
+	 * Runs one sample through the chain
+	 * 
+	 * @param value The input sample
+	 * @returns     The output of the last stage
+	*/
+	inline Output process(AnalogSelectorValue value) {
+		return AnalogSelectorStage<Stage>::run(this->stage, value);
+	}
+
+	/**
+	 * Runs a block of samples through the chain
+	 * 
+	 * @param input  The input samples
+	 * @param count  Number of samples to process
+	 * @param output Buffer for the results, at least 'count' long
+	*/
+	void process(const AnalogSelectorValue* input, size_t count, Output* output) {
+		for (size_t i = 0; i < count; i++) {
+			output[i] = this->process(input[i]);
+		}
+	}
+
+	/**
+	 * Gets the stage at this point in the chain
+	 * 
+	 * @returns Reference to the stage
+	*/
+	Stage& getStage() {
+		return this->stage;
+	}
+
+private:
+	Stage stage;  ///< the stage instance
+};
+
+template<typename Stage, typename... Rest>
+class AnalogSelectorChain<Stage, Rest...> {
+public:
+	typedef typename AnalogSelectorChain<Rest...>::Output Output;  ///< the type of value produced by the chain
+
+	/**
+	 * Class constructor
+	 * 
+	 * @param args Arguments for the last stage's constructor
+	*/
+	template<typename... Args>
+	AnalogSelectorChain(Args... args) : stage(), next(args...) {}
+
+	/** @copydoc AnalogSelectorChain<Stage>::process(AnalogSelectorValue) */
+	inline Output process(AnalogSelectorValue value) {
+		return this->next.process(AnalogSelectorStage<Stage>::run(this->stage, value));
+	}
+
+	/** @copydoc AnalogSelectorChain<Stage>::process(const AnalogSelectorValue*, size_t, Output*) */
+	void process(const AnalogSelectorValue* input, size_t count, Output* output) {
+		for (size_t i = 0; i < count; i++) {
+			output[i] = this->process(input[i]);
+		}
+	}
+
+	/** @copydoc AnalogSelectorChain<Stage>::getStage() */
+	Stage& getStage() {
+		return this->stage;
+	}
+
+	/**
+	 * Gets the remainder of the chain, after this stage
+	 * 
+	 * @returns Reference to the chain of following stages
+	*/
+	AnalogSelectorChain<Rest...>& getNext() {
+		return this->next;
+	}
+
+private:
+	Stage stage;                        ///< the stage instance
+	AnalogSelectorChain<Rest...> next;  ///< the following stages
+};
+
+#endif
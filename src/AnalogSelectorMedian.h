@@ -0,0 +1,233 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ANALOG_SELECTOR_MEDIAN_H
+#define ANALOG_SELECTOR_MEDIAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AnalogSelectorTypes.h"
+
+
+/**
+ * @brief Median selection networks for 3, 5, and 7 samples
+ * 
+ * Each network is a fixed sequence of compare-exchange operations that leaves
+ * the median in the middle element, with no data-dependent control flow. The
+ * operation is supplied by the caller, so the same network can be run on
+ * single values or across several channels at once.
+ * 
+ * @tparam Size Number of samples, 3, 5, or 7
+ */
+template<uint8_t Size>
+struct AnalogSelectorMedianNetwork;
+
+template<>
+struct AnalogSelectorMedianNetwork<3> {
+	template<typename Op>
+	static inline void apply(Op& op) {
+		op(0, 1); op(1, 2); op(0, 1);
+	}
+};
+
+template<>
+struct AnalogSelectorMedianNetwork<5> {
+	template<typename Op>
+	static inline void apply(Op& op) {
+		op(0, 1); op(3, 4); op(0, 3);
+		op(1, 4); op(1, 2); op(2, 3);
+		op(1, 2);
+	}
+};
+
+template<>
+struct AnalogSelectorMedianNetwork<7> {
+	template<typename Op>
+	static inline void apply(Op& op) {
+		op(0, 5); op(0, 3); op(1, 6);
+		op(2, 4); op(0, 1); op(3, 5);
+		op(2, 6); op(2, 3); op(3, 6);
+		op(4, 5); op(1, 4); op(1, 3);
+		op(3, 4);
+	}
+};
+
+
+/**
+ * @brief Median filter for rejecting single-sample spikes
+ * 
+ * This keeps the most recent samples in a small ring buffer and outputs their
+ * median. A spike shorter than half of the window is removed entirely, rather
+ * than being smeared out as with an average.
+ * 
+ * The first sample after construction or a reset fills the whole window, so
+ * the output starts at the first reading.
+ * 
+ * This can be used as a stage in an AnalogSelectorChain.
+ * 
+ * @tparam Size Number of samples in the window, 3, 5, or 7
+ */
+template<uint8_t Size>
+class AnalogSelectorMedian {
+public:
+	/**
+	 * Class constructor
+	*/
+	AnalogSelectorMedian() {
+		reset();
+	}
+
+	/**
+	 * Adds a sample to the window
+	 * 
+	 * @param value The input sample
+	 * @returns     The median of the samples in the window
+	*/
+	AnalogSelectorValue process(AnalogSelectorValue value) {
+		if (!this->seeded) {
+			for (uint8_t i = 0; i < Size; i++) this->samples[i] = value;
+			this->seeded = true;
+			return value;
+		}
+
+		this->samples[this->head] = value;
+		if (++this->head == Size) this->head = 0;
+
+		Sort op;
+		for (uint8_t i = 0; i < Size; i++) op.values[i] = this->samples[i];
+		AnalogSelectorMedianNetwork<Size>::apply(op);
+
+		return op.values[Size / 2];
+	}
+
+	/**
+	 * Resets the window, so that the next sample fills it
+	*/
+	void reset() {
+		this->head = 0;
+		this->seeded = false;
+	}
+
+private:
+	/// Compare-exchange operation on a working copy of the window
+	struct Sort {
+		AnalogSelectorValue values[Size];
+
+		inline void operator()(uint8_t a, uint8_t b) {
+			const AnalogSelectorValue Low  = (this->values[a] < this->values[b]) ? this->values[a] : this->values[b];
+			const AnalogSelectorValue High = (this->values[a] < this->values[b]) ? this->values[b] : this->values[a];
+			this->values[a] = Low;
+			this->values[b] = High;
+		}
+	};
+
+	AnalogSelectorValue samples[Size];  ///< the most recent samples, used as a ring buffer
+	uint8_t head;                       ///< index where the next sample will be written
+	bool seeded;                        ///< whether the window has been filled from a sample
+};
+
+
+/**
+ * @brief Median filter for several channels sampled together
+ * 
+ * This works the same as AnalogSelectorMedian, keeping a separate window for
+ * each channel. The windows are stored with the channels side by side, so
+ * each step of the network is a simple loop across all channels, which the
+ * compiler can vectorize on platforms that support it.
+ * 
+ * @tparam Size     Number of samples in each window, 3, 5, or 7
+ * @tparam Channels Number of channels
+ */
+template<uint8_t Size, size_t Channels>
+class AnalogSelectorMedianBank {
+public:
+	/**
+	 * Class constructor
+	*/
+	AnalogSelectorMedianBank() {
+		reset();
+	}
+
+	/**
+	 * Adds one sample for every channel
+	 * 
+	 * @param input  The input samples, one per channel
+	 * @param output Buffer for the median of each channel, one per channel
+	*/
+	void process(const AnalogSelectorValue* input, AnalogSelectorValue* output) {
+		if (!this->seeded) {
+			for (uint8_t i = 0; i < Size; i++) {
+				for (size_t c = 0; c < Channels; c++) this->samples[i][c] = input[c];
+			}
+			this->seeded = true;
+		}
+		else {
+			for (size_t c = 0; c < Channels; c++) this->samples[this->head][c] = input[c];
+			if (++this->head == Size) this->head = 0;
+		}
+
+		Sort op;
+		for (uint8_t i = 0; i < Size; i++) {
+			for (size_t c = 0; c < Channels; c++) op.values[i][c] = this->samples[i][c];
+		}
+		AnalogSelectorMedianNetwork<Size>::apply(op);
+
+		for (size_t c = 0; c < Channels; c++) output[c] = op.values[Size / 2][c];
+	}
+
+	/**
+	 * Resets the windows, so that the next samples fill them
+	*/
+	void reset() {
+		this->head = 0;
+		this->seeded = false;
+	}
+
+private:
+	/// Compare-exchange operation across all channels of a working copy
+	struct Sort {
+		AnalogSelectorValue values[Size][Channels];
+
+		inline void operator()(uint8_t a, uint8_t b) {
+			AnalogSelectorValue* const A = this->values[a];
+			AnalogSelectorValue* const B = this->values[b];
+
+			for (size_t c = 0; c < Channels; c++) {
+				const AnalogSelectorValue Low  = (A[c] < B[c]) ? A[c] : B[c];
+				const AnalogSelectorValue High = (A[c] < B[c]) ? B[c] : A[c];
+				A[c] = Low;
+				B[c] = High;
+			}
+		}
+	};
+
+	AnalogSelectorValue samples[Size][Channels];  ///< the most recent samples for each channel, used as a ring buffer
+	uint8_t head;                                 ///< index where the next samples will be written
+	bool seeded;                                  ///< whether the windows have been filled from a sample
+};
+
+#endif
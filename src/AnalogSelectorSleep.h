@@ -0,0 +1,90 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ANALOG_SELECTOR_SLEEP_H
+#define ANALOG_SELECTOR_SLEEP_H
+
+#include <stdint.h>
+
+
+/**
+ * @brief Runs one ADC conversion in noise reduction sleep
+ * 
+ * The sequence is written against a power controller rather than the
+ * registers, so that it can be tested on the host with a mock. On AVR the
+ * controller wraps `SREG`, `sei()` / `cli()`, the sleep functions, and the
+ * ADC registers. It provides:
+ * 
+ * ```
+ * uint8_t saveInterrupts();             // the global interrupt state
+ * void restoreInterrupts(uint8_t state);
+ * void enableInterrupts();              // takes effect after the next instruction
+ * void disableInterrupts();
+ * void beginSleep();                    // ADC interrupt and sleep mode on
+ * void sleep();                         // sleeps, starting the conversion
+ * bool converting();
+ * void endSleep();                      // ADC interrupt and sleep mode off
+ * int result();
+ * ```
+ * 
+ * @tparam Power The power controller type
+ */
+template<typename Power>
+struct AnalogSelectorSleep {
+	/**
+	 * Takes one reading from the channel already selected on the ADC
+	 * 
+	 * The CPU sleeps until the conversion completes. If another interrupt
+	 * wakes it first, it goes back to sleep. The global interrupt state is
+	 * restored afterwards, so this can be called with interrupts disabled.
+	 * 
+	 * @param power The power controller
+	 * @returns     The conversion result
+	*/
+	static int convert(Power& power) {
+		const uint8_t State = power.saveInterrupts();
+
+		power.disableInterrupts();
+		power.beginSleep();
+
+		// interrupts are only enabled for the sleep itself. Enabling them
+		// takes effect after the next instruction, so a conversion that
+		// completes between the check and the sleep leaves its interrupt
+		// pending, which wakes the CPU straight away.
+		do {
+			power.enableInterrupts();
+			power.sleep();
+			power.disableInterrupts();
+		} while (power.converting());
+
+		power.endSleep();
+		power.restoreInterrupts(State);
+
+		return power.result();
+	}
+};
+
+#endif
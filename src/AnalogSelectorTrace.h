@@ -0,0 +1,161 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ANALOG_SELECTOR_TRACE_H
+#define ANALOG_SELECTOR_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+
+/**
+ * @brief Fixed-size binary record of a filter event
+ * 
+ * Records are written by AnalogSelectorFilter to its trace sink whenever the
+ * configuration is recalculated or the selection changes. The meaning of the
+ * data fields depends on the record type:
+ * 
+ * ```
+ * Config:    index = number of positions
+ *            data  = range min, range max, selector width, deadzone width
+ * Selection: index = new selection, flags = 1 if calculated relatively
+ *            data  = input, lower edge, upper edge, previous selection
+ * ```
+ * 
+ * Values are truncated to 16 bits.
+ */
+struct AnalogSelectorTraceRecord {
+	enum Type { Config = 0, Selection = 1 };  ///< record types, stored in 'type'
+
+	uint8_t  type;     ///< the type of record, from AnalogSelectorTraceRecord::Type
+	uint8_t  flags;    ///< additional record flags, type dependent
+	uint16_t index;    ///< the position count or selection index, type dependent
+	int16_t  data[4];  ///< record data, type dependent
+};
+
+
+/**
+ * @brief Interface for receiving trace records from a filter
+ */
+class AnalogSelectorTraceSink {
+public:
+	/**
+	 * Handles a trace record from a filter
+	 * 
+	 * This is called inline from the filter, so implementations should
+	 * return as quickly as possible.
+	 * 
+	 * @param record The record to store or send
+	*/
+	virtual void write(const AnalogSelectorTraceRecord& record) = 0;
+};
+
+
+/**
+ * @brief Trace sink that stores the most recent records in memory
+ * 
+ * Once the buffer is full the oldest records are overwritten.
+ * 
+ * @tparam Size Number of records to buffer
+ */
+template<size_t Size>
+class AnalogSelectorTraceBuffer : public AnalogSelectorTraceSink {
+public:
+	/**
+	 * Class constructor
+	*/
+	AnalogSelectorTraceBuffer() : head(0), count(0) {}
+
+	/** @copydoc AnalogSelectorTraceSink::write(const AnalogSelectorTraceRecord&) */
+	void write(const AnalogSelectorTraceRecord& record) {
+		this->records[this->head] = record;
+		if (++this->head == Size) this->head = 0;
+		if (this->count < Size) this->count++;
+	}
+
+	/**
+	 * Removes the oldest record from the buffer
+	 * 
+	 * @param record Output for the record
+	 * @returns      'true' if a record was read, 'false' if the buffer is empty
+	*/
+	bool read(AnalogSelectorTraceRecord& record) {
+		if (this->count == 0) return false;
+
+		const size_t tail = (this->head >= this->count) ? (this->head - this->count) : (this->head + Size - this->count);
+		record = this->records[tail];
+		this->count--;
+
+		return true;
+	}
+
+	/**
+	 * Gets the number of records in the buffer
+	 * 
+	 * @returns The number of records available to read
+	*/
+	size_t available() const {
+		return this->count;
+	}
+
+private:
+	AnalogSelectorTraceRecord records[Size];  ///< record storage, used as a ring buffer
+	size_t head;                              ///< index where the next record will be written
+	size_t count;                             ///< number of records in the buffer
+};
+
+
+#ifdef ARDUINO
+/**
+ * @brief Trace sink that writes raw binary records to an output stream
+ * 
+ * Each record is written as `sizeof(AnalogSelectorTraceRecord)` bytes in the
+ * platform's native byte order, with no framing.
+ */
+class AnalogSelectorTracePrint : public AnalogSelectorTraceSink {
+public:
+	/**
+	 * Class constructor
+	 * 
+	 * @param out Output stream to write to, such as `Serial`
+	*/
+	AnalogSelectorTracePrint(Print& out) : output(out) {}
+
+	/** @copydoc AnalogSelectorTraceSink::write(const AnalogSelectorTraceRecord&) */
+	void write(const AnalogSelectorTraceRecord& record) {
+		this->output.write((const uint8_t*) &record, sizeof(record));
+	}
+
+private:
+	Print& output;  ///< the output stream for records
+};
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ *  Project     AnalogSelector Library
+ *  @author     David Madison
+ *  @link       github.com/dmadison/AnalogSelector-Arduino
+ *  @license    MIT - Copyright (c) 2023 David Madison
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ANALOG_SELECTOR_TYPES_H
+#define ANALOG_SELECTOR_TYPES_H
+
+#include <stdint.h>
+
+
+/**
+ * @brief Integer types for inputs and distances in the input range
+ * 
+ * By default these are 'int' and 'unsigned int', which are 16 bits on 8-bit
+ * platforms and cover the built-in ADCs. Defining `ANALOG_SELECTOR_WIDE`
+ * makes them 32 bits everywhere, for external 16 and 24-bit ADCs and wide
+ * signed ranges. Like the other options this changes the class layout, so it
+ * must be defined globally for every file that includes this library.
+ */
+#ifdef ANALOG_SELECTOR_WIDE
+typedef int32_t  AnalogSelectorValue;  ///< an input value, in the user range
+typedef uint32_t AnalogSelectorSpan;   ///< a distance within the user range
+#else
+typedef int          AnalogSelectorValue;  ///< an input value, in the user range
+typedef unsigned int AnalogSelectorSpan;   ///< a distance within the user range
+#endif
+
+#endif